@@ -2,8 +2,6 @@
 
 #include <glm/glm.hpp>
 #include <vector>
-#include <string>
-#include <unordered_map>
 #include "rendering.h"
 #include "texture.h"
 
@@ -22,20 +20,63 @@ enum BLOCK
     OAK_LEAVES = 10
 };
 
-static std::unordered_map<BLOCK, std::string> blockNames = {
-    {BLOCK::AIR_BLOCK, "Air"},
-    {BLOCK::GRASS_BLOCK, "Grass"},
-    {BLOCK::DIRT_BLOCK, "Dirt"},
-    {BLOCK::STONE_BLOCK, "Stone"},
-    {BLOCK::FOCUS, "Focus"},
-    {BLOCK::BEDROCK_BLOCK, "Bedrock"},
-    {BLOCK::SNOW_BLOCK, "Snow"},
-    {BLOCK::WATER_BLOCK, "Water"},
-    {BLOCK::SAND_BLOCK, "Sand"},
-    {BLOCK::OAK_WOOD, "Oak Wood"},
-    {BLOCK::OAK_LEAVES, "Oak Leaves"}
+#define BLOCK_COUNT 11
+
+enum RENDER_KIND
+{
+    RENDER_NONE,
+    RENDER_REGULAR,
+    RENDER_LIQUID
 };
 
+// Everything the game needs to know about a kind of block, looked up by
+// indexing blockProperties with the BLOCK
+typedef struct
+{
+    BLOCK block;
+    const char *name;
+    RENDER_KIND render;
+    bool opaque; // hides the faces of the blocks next to it
+    bool solid;  // can be broken, air and liquids can't
+    UVcoords textures[3]; // bottom, side, top
+} BlockProperties;
+
+constexpr BlockProperties blockProperties[BLOCK_COUNT] = {
+    {BLOCK::AIR_BLOCK, "Air", RENDER_NONE, false, false, {}},
+    {BLOCK::GRASS_BLOCK, "Grass", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 1), getTextureCoordsFromAtlas(0, 2)}},
+    {BLOCK::DIRT_BLOCK, "Dirt", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 0)}},
+    {BLOCK::STONE_BLOCK, "Stone", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 3), getTextureCoordsFromAtlas(0, 3), getTextureCoordsFromAtlas(0, 3)}},
+    {BLOCK::FOCUS, "Focus", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 4), getTextureCoordsFromAtlas(0, 4), getTextureCoordsFromAtlas(0, 4)}},
+    {BLOCK::BEDROCK_BLOCK, "Bedrock", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 5), getTextureCoordsFromAtlas(0, 5), getTextureCoordsFromAtlas(0, 5)}},
+    {BLOCK::SNOW_BLOCK, "Snow", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 6), getTextureCoordsFromAtlas(0, 6), getTextureCoordsFromAtlas(0, 6)}},
+    {BLOCK::WATER_BLOCK, "Water", RENDER_LIQUID, false, false, {getTextureCoordsFromAtlas(0, 7), getTextureCoordsFromAtlas(0, 7), getTextureCoordsFromAtlas(0, 7)}},
+    {BLOCK::SAND_BLOCK, "Sand", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 8), getTextureCoordsFromAtlas(0, 8), getTextureCoordsFromAtlas(0, 8)}},
+    {BLOCK::OAK_WOOD, "Oak Wood", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 11), getTextureCoordsFromAtlas(0, 9), getTextureCoordsFromAtlas(0, 11)}},
+    {BLOCK::OAK_LEAVES, "Oak Leaves", RENDER_REGULAR, true, true, {getTextureCoordsFromAtlas(0, 10), getTextureCoordsFromAtlas(0, 10), getTextureCoordsFromAtlas(0, 10)}},
+};
+
+constexpr bool blockPropertiesInOrder()
+{
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        if (blockProperties[i].block != i)
+            return false;
+    }
+    return true;
+}
+static_assert(blockPropertiesInOrder(), "blockProperties must list every BLOCK in enum order");
+
+// The texture of a block's face, face being a cover bit
+constexpr const UVcoords &blockFaceTexture(BLOCK block, int face)
+{
+    return blockProperties[block].textures[face == 16 ? 0 : face == 32 ? 2 : 1];
+}
+
+constexpr bool isLiquid(BLOCK block)
+{
+    return blockProperties[block].render == RENDER_LIQUID;
+}
+
 typedef struct
 {
     int x, y, z;
@@ -46,59 +87,26 @@ typedef struct
 {
     BLOCK block;
     char cover;
-    glm::vec3 blockPos;
+    glm::ivec3 blockPos; // within the chunk
     std::vector<Vertex> &chunkVertices;
-    std::vector<unsigned int> &chunkIndices;
-    unsigned int &indiceOffset;
 } BlockRenderInfo;
 
 typedef struct
 {
     BLOCK block;
     char cover;
-    glm::vec3 blockPos;
+    glm::ivec3 blockPos; // within the chunk
     std::vector<Vertex> &chunkVertices;
-    std::vector<unsigned int> &chunkIndices;
-    unsigned int &indiceOffset;
     bool liquidOnTop;
 } LiquidRenderInfo;
 
+// Emits a rectangle of w by h faces of one direction, face being its cover
+// bit. origin is the chunk relative position of the block in the rectangle's
+// low corner. w runs along x for north, south, bottom and top and along z for
+// west and east, h along y for the sides and along z for bottom and top. The
+// texture repeats once per block. The four vertices go round the face, they
+// are drawn with the quad index pattern of fillQuadIndices.
+void emitFace(int face, glm::ivec3 origin, int w, int h, const UVcoords &coords, bool lowered, std::vector<Vertex> &vertices);
+
 void renderRegularBlock(BlockRenderInfo &renderInfo);
 void renderLiquidBlock(LiquidRenderInfo &renderInfo);
-void renderAirBlock(BlockRenderInfo &renderInfo);
-
-static std::unordered_map<BLOCK, std::vector<UVcoords>> blockTextureCoords = {
-    {BLOCK::AIR_BLOCK, {}},
-    {BLOCK::GRASS_BLOCK, {getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 1), getTextureCoordsFromAtlas(0, 2)}},
-    {BLOCK::DIRT_BLOCK, {getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 0), getTextureCoordsFromAtlas(0, 0)}},
-    {BLOCK::STONE_BLOCK, {getTextureCoordsFromAtlas(0, 3), getTextureCoordsFromAtlas(0, 3), getTextureCoordsFromAtlas(0, 3)}},
-    {BLOCK::FOCUS, {getTextureCoordsFromAtlas(0, 4), getTextureCoordsFromAtlas(0, 4), getTextureCoordsFromAtlas(0, 4)}},
-    {BLOCK::BEDROCK_BLOCK, {getTextureCoordsFromAtlas(0, 5), getTextureCoordsFromAtlas(0, 5), getTextureCoordsFromAtlas(0, 5)}},
-    {BLOCK::SNOW_BLOCK, {getTextureCoordsFromAtlas(0, 6), getTextureCoordsFromAtlas(0, 6), getTextureCoordsFromAtlas(0, 6)}},
-    {BLOCK::WATER_BLOCK, {getTextureCoordsFromAtlas(0, 7)}},
-    {BLOCK::SAND_BLOCK, {getTextureCoordsFromAtlas(0, 8), getTextureCoordsFromAtlas(0, 8), getTextureCoordsFromAtlas(0, 8)}},
-    {BLOCK::OAK_WOOD, {getTextureCoordsFromAtlas(0, 11), getTextureCoordsFromAtlas(0, 9), getTextureCoordsFromAtlas(0, 11)}},
-    {BLOCK::OAK_LEAVES, {getTextureCoordsFromAtlas(0, 10), getTextureCoordsFromAtlas(0, 10), getTextureCoordsFromAtlas(0, 10)}},
-};
-
-static std::unordered_map<BLOCK, void (*)(BlockRenderInfo &renderInfo)> blockRenderFunctions = {
-    {BLOCK::AIR_BLOCK, renderAirBlock},
-    {BLOCK::GRASS_BLOCK, renderRegularBlock},
-    {BLOCK::DIRT_BLOCK, renderRegularBlock},
-    {BLOCK::STONE_BLOCK, renderRegularBlock},
-    {BLOCK::FOCUS, renderRegularBlock},
-    {BLOCK::BEDROCK_BLOCK, renderRegularBlock},
-    {BLOCK::SNOW_BLOCK, renderRegularBlock},
-    {BLOCK::SAND_BLOCK, renderRegularBlock},
-    {BLOCK::OAK_WOOD, renderRegularBlock},
-    {BLOCK::OAK_LEAVES, renderRegularBlock},
-};
-
-static std::unordered_map<BLOCK, void (*)(LiquidRenderInfo &renderInfo)> liquidRenderFunctions = {
-    {BLOCK::WATER_BLOCK, renderLiquidBlock},
-};
-
-static bool isLiquid(BLOCK block)
-{
-    return block == BLOCK::WATER_BLOCK;
-}
@@ -18,6 +18,7 @@ private:
     float height;
 
     bool isJumping;
+    bool spawned;
 
     glm::vec3 velocity;
     glm::vec3 acceleration;
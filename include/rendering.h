@@ -1,9 +1,67 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
 
+// A vertex packed into two words, decoded again by the object shader.
+// Positions are relative to the origin of the chunk the vertex belongs to,
+// which the renderer passes in as a uniform.
+//
+// position: x 5 bits, y 9 bits, z 5 bits, then one bit that lowers the
+//           vertex by 0.1 for the surface of a liquid
+// texture:  atlas tile column 6 bits, tile row 6 bits, then how many times
+//           the tile repeats up to the vertex along u and v, 5 bits each
 typedef struct
 {
-    glm::vec3 pos;
-    glm::vec2 texCoord;
-} Vertex;
\ No newline at end of file
+    uint32_t position;
+    uint32_t texture;
+} Vertex;
+
+typedef struct
+{
+    int x, y, z;
+    bool lowered;
+    int tileCol, tileRow;
+    int repeatU, repeatV;
+} UnpackedVertex;
+
+inline Vertex packVertex(int x, int y, int z, bool lowered, int tileCol, int tileRow, int repeatU, int repeatV)
+{
+    return {
+        (uint32_t)x | (uint32_t)y << 5 | (uint32_t)z << 14 | (uint32_t)lowered << 19,
+        (uint32_t)tileCol | (uint32_t)tileRow << 6 | (uint32_t)repeatU << 12 | (uint32_t)repeatV << 17,
+    };
+}
+
+inline UnpackedVertex unpackVertex(Vertex vertex)
+{
+    return {
+        (int)(vertex.position & 31),
+        (int)(vertex.position >> 5 & 511),
+        (int)(vertex.position >> 14 & 31),
+        (vertex.position >> 19 & 1) != 0,
+        (int)(vertex.texture & 63),
+        (int)(vertex.texture >> 6 & 63),
+        (int)(vertex.texture >> 12 & 31),
+        (int)(vertex.texture >> 17 & 31),
+    };
+}
+
+// Faces are stored as four vertices each, going round the face. Every face
+// is drawn as the same two triangles, so one list of indices serves all meshes.
+inline void fillQuadIndices(std::vector<unsigned int> &indices, size_t quads)
+{
+    indices.resize(quads * 6);
+    for (size_t i = 0; i < quads; i++)
+    {
+        unsigned int first = (unsigned int)(i * 4);
+        indices[i * 6 + 0] = first + 0;
+        indices[i * 6 + 1] = first + 1;
+        indices[i * 6 + 2] = first + 2;
+        indices[i * 6 + 3] = first + 2;
+        indices[i * 6 + 4] = first + 3;
+        indices[i * 6 + 5] = first + 0;
+    }
+}
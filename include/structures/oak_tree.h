@@ -1,55 +1,112 @@
 #pragma once
 
-#include "block.h"
+#include "structures/structure.h"
 
 namespace Structure
 {
-    typedef struct
-    {
-        static const unsigned int x = 5; // width
-        static const unsigned int y = 5; // height (vertical layers)
-        static const unsigned int z = 5; // depth
-        BLOCK blocks[x][y][z] = {
-            {
-                // Layer 0 (Bottom of the tree, base)
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_WOOD, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-            },
-            {
-                // Layer 1 (Trunk)
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_WOOD, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-            },
-            {
-                // Layer 2 (More trunk)
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_WOOD, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK, AIR_BLOCK},
-            },
-            {
-                // Layer 3 (Leaves)
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, OAK_LEAVES, OAK_LEAVES, OAK_LEAVES, AIR_BLOCK},
-                {OAK_LEAVES, OAK_LEAVES, OAK_WOOD, OAK_LEAVES, OAK_LEAVES},
-                {AIR_BLOCK, OAK_LEAVES, OAK_LEAVES, OAK_LEAVES, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-            },
-            {
-                // Layer 4 (Top of the tree)
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-                {OAK_LEAVES, OAK_LEAVES, OAK_LEAVES, OAK_LEAVES, OAK_LEAVES},
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-                {AIR_BLOCK, AIR_BLOCK, OAK_LEAVES, AIR_BLOCK, AIR_BLOCK},
-            },
-        };
-    } OAK_TREE_ONE;
+    // The tree of the hills: an 8 block trunk standing in the grass block,
+    // a 5x5 canopy over its top three blocks with a ragged +x and +z edge and
+    // a 3x3 crown above
+    constexpr char OAK_TREE_TEXT[] =
+        // Layers 0 - 5 (Trunk)
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        // Layers 6 - 7 (Canopy around the top of the trunk)
+        "LLLLl"
+        "LLLLl"
+        "LLWLl"
+        "LLLLl"
+        "lllll"
+
+        "LLLLl"
+        "LLLLl"
+        "LLWLl"
+        "LLLLl"
+        "lllll"
+
+        // Layer 8 (Canopy)
+        "LLLLl"
+        "LLLLl"
+        "LLLLl"
+        "LLLLl"
+        "lllll"
+
+        // Layer 9 (Crown)
+        "....."
+        ".LLL."
+        ".LLL."
+        ".LLL."
+        ".....";
+
+    constexpr auto OAK_TREE = STRUCTURE_TEMPLATE(OAK_TREE_TEXT, 5, 10, 5, 2, 2);
+
+    constexpr char SMALL_OAK_TREE_TEXT[] =
+        // Layers 0 - 2 (Trunk)
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        "....."
+        "....."
+        "..W.."
+        "....."
+        "....."
+
+        // Layer 3 (Leaves)
+        "..L.."
+        ".LLL."
+        "LLWLL"
+        ".LLL."
+        "..L.."
+
+        // Layer 4 (Top of the tree)
+        "..L.."
+        "..L.."
+        "LLLLL"
+        "..L.."
+        "..L..";
+
+    constexpr auto SMALL_OAK_TREE = STRUCTURE_TEMPLATE(SMALL_OAK_TREE_TEXT, 5, 5, 5, 2, 2);
 }
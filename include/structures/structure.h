@@ -1,3 +1,101 @@
 #pragma once
 
-void placeStructure(int x, int y, int z, Structure::)
\ No newline at end of file
+#include <cstddef>
+
+#include "block.h"
+
+// Structures are written as dense text templates and compiled into sparse
+// lists of their non-air blocks at compile time, so placing one is a loop
+// over exactly the blocks it has.
+//
+// A template is one layer per y from the bottom up, each layer Z rows of X
+// characters, rows going towards +z and characters towards +x:
+//   '.' air
+//   'W' oak wood
+//   'L' oak leaves
+//   'l' oak leaves, only placed when the structure's random draw comes up
+namespace Structure
+{
+    // A block relative to the structure's origin
+    typedef struct
+    {
+        int x, y, z;
+        BLOCK block;
+    } Offset;
+
+    // blocks are always placed, chanceBlocks each need a random draw and are
+    // listed in the order the draws are made. The bounds cover both lists.
+    template <size_t Count, size_t ChanceCount>
+    struct Template
+    {
+        Offset blocks[Count > 0 ? Count : 1];
+        Offset chanceBlocks[ChanceCount > 0 ? ChanceCount : 1];
+        size_t count;
+        size_t chanceCount;
+        int minX, maxX, minY, maxY, minZ, maxZ;
+    };
+
+    constexpr BLOCK cellBlock(char cell)
+    {
+        return cell == 'W' ? OAK_WOOD : cell == 'L' || cell == 'l' ? OAK_LEAVES : cell == '.' ? AIR_BLOCK : throw "unknown structure template cell";
+    }
+
+    constexpr bool isChanceCell(char cell)
+    {
+        return cell == 'l';
+    }
+
+    template <int X, int Y, int Z>
+    constexpr size_t countCells(const char *text, bool chance)
+    {
+        size_t count = 0;
+        for (int i = 0; i < X * Y * Z; i++)
+        {
+            if (cellBlock(text[i]) != AIR_BLOCK && isChanceCell(text[i]) == chance)
+                count++;
+        }
+        return count;
+    }
+
+    // Blocks are listed x first, then z, then y, which is also the order of
+    // the chance draws. originX and originZ are the template column that
+    // ends up on the placement position, y 0 is the placement height.
+    template <int X, int Y, int Z, size_t Count, size_t ChanceCount>
+    constexpr Template<Count, ChanceCount> compile(const char *text, int originX, int originZ)
+    {
+        Template<Count, ChanceCount> result = {};
+        result.minX = result.minY = result.minZ = X + Y + Z;
+        result.maxX = result.maxY = result.maxZ = -(X + Y + Z);
+        for (int x = 0; x < X; x++)
+        {
+            for (int z = 0; z < Z; z++)
+            {
+                for (int y = 0; y < Y; y++)
+                {
+                    char cell = text[y * X * Z + z * X + x];
+                    BLOCK block = cellBlock(cell);
+                    if (block == AIR_BLOCK)
+                        continue;
+
+                    Offset offset = {x - originX, y, z - originZ, block};
+                    if (isChanceCell(cell))
+                        result.chanceBlocks[result.chanceCount++] = offset;
+                    else
+                        result.blocks[result.count++] = offset;
+
+                    result.minX = offset.x < result.minX ? offset.x : result.minX;
+                    result.maxX = offset.x > result.maxX ? offset.x : result.maxX;
+                    result.minY = offset.y < result.minY ? offset.y : result.minY;
+                    result.maxY = offset.y > result.maxY ? offset.y : result.maxY;
+                    result.minZ = offset.z < result.minZ ? offset.z : result.minZ;
+                    result.maxZ = offset.z > result.maxZ ? offset.z : result.maxZ;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+// Compiles a text template of X * Y * Z cells into a Structure::Template
+#define STRUCTURE_TEMPLATE(text, X, Y, Z, originX, originZ) \
+    Structure::compile<X, Y, Z, Structure::countCells<X, Y, Z>(text, false), Structure::countCells<X, Y, Z>(text, true)>(text, originX, originZ)
@@ -11,6 +11,19 @@ public:
 typedef struct
 {
     float u1, v1, u2, v2;
+    int row, col;
 } UVcoords;
 
-UVcoords getTextureCoordsFromAtlas(int row, int col);
\ No newline at end of file
+#define ATLAS_SIZE 1024.f
+#define ATLAS_TILE_SIZE 16.f
+
+constexpr UVcoords getTextureCoordsFromAtlas(int row, int col)
+{
+    float tileWidthU = ATLAS_TILE_SIZE / ATLAS_SIZE;
+    float tileHeightV = ATLAS_TILE_SIZE / ATLAS_SIZE;
+
+    float startU = col * tileWidthU;
+    float startV = row * tileHeightV;
+
+    return {startU, startV, startU + tileWidthU, startV + tileHeightV, row, col};
+}
@@ -1,4 +1,9 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <queue>
@@ -33,3 +38,55 @@ void ThreadPool::enqueue(F &&f)
     }
     condition.notify_one();
 }
+
+// Runs tasks on a fixed set of workers, each with its own deque. A worker
+// works through its own deque in order and, once it is empty, steals from
+// the others, so work spreads over whichever cores are idle. parallelFor
+// splits one job into parts that the calling thread and idle workers claim
+// one at a time. Its helpers go to the front of a deque, so the job under
+// way finishes before new ones start: a lone chunk uses every core, while
+// many chunks at once mostly run side by side.
+class TaskScheduler
+{
+public:
+    // hardware_concurrency may report 0, the scheduler always has a worker
+    TaskScheduler(size_t numThreads);
+    // Runs every task that was submitted before returning
+    ~TaskScheduler();
+
+    template <class F>
+    void submit(F &&f);
+    // Calls body(0) .. body(count - 1), some of them on other threads, and
+    // returns once all of them returned. Safe to call from inside a task.
+    // The caller runs other queued tasks while it waits, so it must not hold
+    // a lock those tasks could take. The first exception a part throws is
+    // rethrown once every part is done.
+    void parallelFor(int count, const std::function<void(int)> &body);
+    size_t getThreadCount() const;
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex deque_mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queuedCount;
+    std::atomic<size_t> nextQueue;
+
+    std::mutex sleep_mtx;
+    std::condition_variable condition;
+    bool stop;
+
+    void push(std::function<void()> task, bool urgent);
+    bool runOne(size_t self);
+    void workerLoop(size_t index);
+};
+
+template <class F>
+void TaskScheduler::submit(F &&f)
+{
+    push(std::function<void()>(std::forward<F>(f)), false);
+}
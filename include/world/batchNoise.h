@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "PerlinNoise.hpp"
+
+// Evaluates siv::PerlinNoise octave noise for many points per call. The
+// points are processed in SIMD lanes (AVX2 when the CPU has it, SSE2
+// otherwise) and every lane does the exact operations of the scalar
+// library in the same order, so the results are bit for bit the same as
+// perlin.octave2D_01 / perlin.octave3D_01 and the terrain does not change.
+class BatchPerlin
+{
+public:
+    BatchPerlin(const siv::PerlinNoise &perlin);
+
+    void octave2D_01(const double *x, const double *y, double *out, int count, int octaves, double persistence = 0.5) const;
+    void octave3D_01(const double *x, const double *y, const double *z, double *out, int count, int octaves, double persistence = 0.5) const;
+
+    // Name of the instruction set the batches run on
+    const char *getPath() const;
+
+private:
+    const siv::PerlinNoise &perlin;
+    uint8_t permutation[256];
+    bool useAvx2;
+
+    void octave3D(const double *x, const double *y, const double *z, bool zIsConstant, double *out, int count, int octaves, double persistence) const;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ChunkStorage;
+
+// Small LZ77 style byte codec, used for region files and for chunks parked
+// in the cold tier. A stream is the decoded size followed by tokens of
+// (literal count, literals, match length, match offset), all counts as
+// varints. Matches may overlap their own output, so a run of one repeated
+// byte is a single offset 1 match.
+void lzCompress(const uint8_t *in, size_t size, std::vector<uint8_t> &out);
+bool lzDecompress(const uint8_t *in, size_t size, std::vector<uint8_t> &out);
+
+// Serializes the chunk sections and compresses them
+void encodeChunk(const ChunkStorage &data, std::vector<uint8_t> &out);
+bool decodeChunk(const uint8_t *in, size_t size, ChunkStorage &data);
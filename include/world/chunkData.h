@@ -2,14 +2,70 @@
 
 #include <unordered_map>
 #include <deque>
+#include <memory>
+#include <vector>
 
 #include "world/chunkPos.h"
+#include "world/chunkGrid.h"
 #include "block.h"
 
 #define CHUNK_SIZE 16
 #define CHUNK_HEIGHT 256
 #define BLOCKS_PER_CHUNK CHUNK_SIZE *CHUNK_HEIGHT *CHUNK_SIZE
+#define SECTION_HEIGHT 16
+#define SECTIONS_PER_CHUNK (CHUNK_HEIGHT / SECTION_HEIGHT)
+#define BLOCKS_PER_SECTION (CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE)
 #define WATER_LEVEL 58
+#define BEDROCK_HEIGHT 3
 
-typedef std::unordered_map<ChunkPos, std::vector<char>, ChunkPosHash, ChunkPosEqual> ChunkDataMap;
-typedef std::unordered_map<ChunkPos, std::deque<BlockWithPos>, ChunkPosHash, ChunkPosEqual> StructQueue;
+// Carve caves with the noise evaluated at every voxel instead of the
+// interpolated lattice. Slower, only meant for comparing the two.
+extern bool exact_caves;
+
+// Print a line for every chunk that finishes generating. The tools turn it
+// off to keep their reports readable.
+extern bool log_chunk_generation;
+
+enum BIOME
+{
+    PLAINS_BIOME = 0,
+    HILLS_BIOME = 1,
+    MOUNTAINS_BIOME = 2
+};
+
+// How far a chunk has come through generation. Shape, carve and fluid only
+// touch the chunk itself. Decorate also writes into the neighbours, so a
+// chunk is only decorated once all eight around it are past FLUID_STAGE.
+enum GenerationStage
+{
+    EMPTY_STAGE = 0,
+    SHAPED_STAGE = 1,
+    CARVED_STAGE = 2,
+    FLUID_STAGE = 3,
+    DECORATED_STAGE = 4
+};
+
+class ChunkStorage;
+
+// Chunk data is shared as immutable snapshots. Edits copy the chunk and swap
+// the new version into the map, so readers holding an older snapshot (the
+// mesher, the raycast) never see it change underneath them.
+typedef std::shared_ptr<const ChunkStorage> ChunkSnapshot;
+
+typedef ChunkGrid<ChunkSnapshot> ChunkDataMap;
+
+// Chunks that are still retained but too far away to be meshed are kept
+// compressed with the chunk codec until something asks for them again
+struct ColdChunk
+{
+    std::vector<uint8_t> encoded;
+    bool clean = false; // the region store already holds this exact chunk
+};
+typedef ChunkGrid<ColdChunk> ColdChunkMap;
+// Structure blocks of one decoration, split by the chunk they land in: the
+// decorated chunk and the 8 around it, at (dz + 1) * 3 + dx + 1
+#define STRUCT_QUEUE_CHUNKS 9
+typedef struct
+{
+    std::vector<BlockWithPos> chunks[STRUCT_QUEUE_CHUNKS];
+} StructQueue;
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+
+#include "world/chunkPos.h"
+
+// Fixed size toroidal window of chunks. A chunk lives in the cell given by
+// its coordinates modulo the window size, and the cell remembers the full
+// coordinate so stale entries from the other side of the torus are never
+// mistaken for the requested chunk. As long as every chunk that has to stay
+// resident is within `radius` of the player no two of them share a cell, and
+// moving the player needs no rehashing: inserting a new chunk simply
+// replaces whatever stale chunk was in its cell.
+template <typename T>
+class ChunkGrid
+{
+public:
+    ChunkGrid(int radius) : size(2 * radius + 1), cells(size * size)
+    {
+    }
+
+    bool contains(ChunkPos pos) const
+    {
+        const Cell &cell = cellFor(pos);
+        return cell.occupied && cell.pos == pos;
+    }
+
+    T *find(ChunkPos pos)
+    {
+        Cell &cell = cellFor(pos);
+        return (cell.occupied && cell.pos == pos) ? &cell.value : nullptr;
+    }
+
+    const T *find(ChunkPos pos) const
+    {
+        const Cell &cell = cellFor(pos);
+        return (cell.occupied && cell.pos == pos) ? &cell.value : nullptr;
+    }
+
+    T &insert(ChunkPos pos, T value)
+    {
+        Cell &cell = cellFor(pos);
+        cell.pos = pos;
+        cell.occupied = true;
+        cell.value = std::move(value);
+        return cell.value;
+    }
+
+    // The entry that inserting pos would overwrite, if it belongs to another chunk
+    T *findOccupant(ChunkPos pos, ChunkPos &occupantPos)
+    {
+        Cell &cell = cellFor(pos);
+        if (!cell.occupied || cell.pos == pos)
+            return nullptr;
+        occupantPos = cell.pos;
+        return &cell.value;
+    }
+
+    void erase(ChunkPos pos)
+    {
+        Cell &cell = cellFor(pos);
+        if (cell.occupied && cell.pos == pos)
+        {
+            cell.occupied = false;
+            cell.value = T();
+        }
+    }
+
+    // Calls func(ChunkPos, T &) for every occupied cell
+    template <class F>
+    void forEach(F &&func)
+    {
+        for (Cell &cell : cells)
+        {
+            if (cell.occupied)
+                func(cell.pos, cell.value);
+        }
+    }
+
+    int getSize() const
+    {
+        return size;
+    }
+
+private:
+    struct Cell
+    {
+        ChunkPos pos = {0, 0};
+        bool occupied = false;
+        T value = T();
+    };
+
+    int size;
+    std::vector<Cell> cells;
+
+    Cell &cellFor(ChunkPos pos)
+    {
+        return cells[positiveMod(pos.x, size) + positiveMod(pos.z, size) * size];
+    }
+
+    const Cell &cellFor(ChunkPos pos) const
+    {
+        return cells[positiveMod(pos.x, size) + positiveMod(pos.z, size) * size];
+    }
+};
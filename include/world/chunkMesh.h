@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "world/chunkData.h"
+#include "world/chunkStorage.h"
 #include "world/chunkPos.h"
 
 #include "glError.h"
@@ -11,6 +12,9 @@
 #include "rendering.h"
 
 extern int render_distance;
+// Merge the opaque faces of each section into rectangles instead of meshing
+// every face on its own
+extern bool greedy_meshing;
 
 const siv::PerlinNoise::seed_type seed = 7549u;
 const siv::PerlinNoise perlin{seed};
@@ -20,17 +24,42 @@ const siv::PerlinNoise perlin{seed};
 typedef struct
 {
     ChunkPos pos;
-    unsigned int VBO_opaque, EBO_opaque, VAO_opaque;
-    unsigned int VBO_transparent, EBO_transparent, VAO_transparent;
+    unsigned int VBO_opaque, VAO_opaque;
+    unsigned int VBO_transparent, VAO_transparent;
 
+    // Four vertices per face, the indices come from the shared quad index
+    // buffer
     std::vector<Vertex> vertices_opaque;
-    std::vector<unsigned int> indices_opaque;
-
     std::vector<Vertex> vertices_transparent;
-    std::vector<unsigned int> indices_transparent;
 
     bool isInitialized;
     bool transparentInitialized;
 } ChunkMesh;
 
-typedef std::unordered_map<ChunkPos, ChunkMesh, ChunkPosHash, ChunkPosEqual> ChunkMeshMap;
+typedef ChunkGrid<ChunkMesh> ChunkMeshMap;
+
+// A chunk together with its four direct neighbours, everything the mesher
+// needs to decide which faces are visible. Holding the snapshots pins them
+// for the duration of the mesh job.
+typedef struct
+{
+    ChunkSnapshot chunkData;
+    ChunkSnapshot northChunkData;
+    ChunkSnapshot southChunkData;
+    ChunkSnapshot westChunkData;
+    ChunkSnapshot eastChunkData;
+} ChunkData;
+
+// The visible faces of every voxel of one section as cover bits, indexed
+// [x][y][z] with y counted from the bottom of the section. liquidOnTop marks
+// water with more water above it, whose surface isn't lowered.
+typedef struct
+{
+    char covers[CHUNK_SIZE][SECTION_HEIGHT][CHUNK_SIZE];
+    bool liquidOnTop[CHUNK_SIZE][SECTION_HEIGHT][CHUNK_SIZE];
+} SectionFaces;
+
+void cullSectionFaces(ChunkData &chunkData, int section, SectionFaces &faces);
+void meshChunkData(ChunkPos pos, ChunkData &chunkData, ChunkMesh &chunkMesh);
+// Bytes the mesh's uploaded buffers take on the GPU
+size_t chunkMeshGpuBytes(const ChunkMesh &chunkMesh);
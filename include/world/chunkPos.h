@@ -16,7 +16,9 @@ struct ChunkPosHash
 {
     std::size_t operator()(const ChunkPos &v) const noexcept
     {
-        return std::hash<int>()(v.x) ^ std::hash<int>()(v.z);
+        // pack both coordinates so (a, b) and (b, a) and the x == z diagonal
+        // don't all collide the way hash(x) ^ hash(z) does
+        return std::hash<unsigned long long>()(((unsigned long long)(unsigned int)v.x << 32) | (unsigned int)v.z);
     }
 };
 
@@ -26,4 +28,9 @@ struct ChunkPosEqual
     {
         return v1.x == v2.x && v1.z == v2.z;
     }
-};
\ No newline at end of file
+};
+
+inline int positiveMod(int value, int mod)
+{
+    return (value % mod + mod) % mod;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "world/chunkData.h"
+#include "world/voxelLayout.h"
+#include "block.h"
+
+#define SECTION_WORDS (BLOCKS_PER_SECTION / 64)
+
+// Index of a column in the per chunk column layers
+inline int columnIndex(int x, int z)
+{
+    return x * CHUNK_SIZE + z;
+}
+
+// Anything other than air and water hides the faces next to it
+inline bool isOpaqueBlock(BLOCK block)
+{
+    return blockProperties[block].opaque;
+}
+
+// One 16x16x16 slice of a chunk column. A uniform section (all air, all
+// stone, ...) only stores its fill block. Otherwise every voxel stores an
+// index into a small palette of BLOCK values, packed at 1, 2, 4 or 8 bits
+// per block depending on how many distinct blocks the section holds.
+//
+// Mixed sections also keep one bit per voxel, in the order of the packed
+// indices, for occupied (anything but air) and opaque (anything but air and
+// water). These answer the mesher's, raycast's and collision's questions
+// without decoding the palette. Without water in the section the two are the
+// same, so the opaque bitmap is only allocated once water shows up.
+class ChunkSection
+{
+public:
+    ChunkSection();
+
+    BLOCK get(int x, int y, int z) const;
+    void set(int x, int y, int z, BLOCK block);
+    // Sets fromY to toY of one column with a single palette lookup
+    void fillColumn(int x, int z, int fromY, int toY, BLOCK block);
+    void fill(BLOCK block);
+    void compact();
+
+    bool isOccupied(int x, int y, int z) const;
+    bool isOpaque(int x, int y, int z) const;
+    // The same for a whole row along x, bit x of the result is the voxel at x
+    uint16_t occupiedRow(int y, int z) const;
+    uint16_t opaqueRow(int y, int z) const;
+
+    bool isUniform() const;
+    bool isEmpty() const;
+    int getBitsPerBlock() const;
+    size_t getPaletteSize() const;
+    size_t memoryUsage() const;
+
+    void serialize(std::vector<uint8_t> &out) const;
+    size_t deserialize(const uint8_t *in, size_t size);
+
+private:
+    int bitsPerBlock;
+    unsigned int nonAirCount;
+    std::vector<BLOCK> palette;
+    std::vector<uint64_t> packed;
+    std::vector<uint64_t> occupied;
+    std::vector<uint64_t> opaque;
+
+    unsigned int getPaletteIndex(BLOCK block);
+    void grow(int newBitsPerBlock);
+    void rebuildBitmaps();
+    static uint16_t bitmapRow(const std::vector<uint64_t> &bits, int y, int z);
+};
+
+// Block storage for a single chunk column, split into vertical sections.
+// Keeps a bitmask of which sections hold anything other than air.
+//
+// Next to the blocks it keeps a layer with one entry per x/z column: the
+// height of the highest non-air block, kept up to date by every write, and
+// the biome generation picked for the column. Later generation passes, the
+// mesher and spawning read these instead of scanning columns.
+class ChunkStorage
+{
+public:
+    ChunkStorage();
+
+    BLOCK get(int x, int y, int z) const;
+    void set(int x, int y, int z, BLOCK block);
+    void fillColumn(int x, int z, int fromY, int toY, BLOCK block);
+    void compact();
+
+    bool isOccupied(int x, int y, int z) const;
+    bool isOpaque(int x, int y, int z) const;
+
+    // Highest non-air block in the column, -1 when it is all air
+    int getHeight(int x, int z) const;
+    int getMinHeight() const;
+    int getMaxHeight() const;
+    BIOME getBiome(int x, int z) const;
+    void setBiome(int x, int z, BIOME biome);
+
+    GenerationStage getStage() const;
+    void setStage(GenerationStage stage);
+
+    const ChunkSection &getSection(int section) const;
+    void fillSection(int section, BLOCK block);
+    // For generation passes that fill different sections from different
+    // threads. Writes through it leave the column layer and the non-empty
+    // mask alone, rebuildColumns brings them up to date afterwards.
+    ChunkSection &editSection(int section);
+    void rebuildColumns();
+    uint16_t getNonEmptyMask() const;
+
+    size_t memoryUsage() const;
+
+    void serialize(std::vector<uint8_t> &out) const;
+    bool deserialize(const uint8_t *in, size_t size);
+
+private:
+    ChunkSection sections[SECTIONS_PER_CHUNK];
+    uint16_t nonEmptyMask;
+    int16_t heights[CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t biomes[CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t stage;
+
+    void updateHeight(int x, int z, int fromY);
+};
+
+// The bitmap lookups sit in every neighbour test of the mesher, so they are
+// inlined here
+inline bool ChunkSection::isOccupied(int x, int y, int z) const
+{
+    if (bitsPerBlock == 0)
+        return palette[0] != BLOCK::AIR_BLOCK;
+
+    unsigned int voxel = sectionIndex(x, y, z);
+    return (occupied[voxel >> 6] >> (voxel & 63)) & 1;
+}
+
+inline bool ChunkSection::isOpaque(int x, int y, int z) const
+{
+    if (bitsPerBlock == 0)
+        return isOpaqueBlock(palette[0]);
+
+    unsigned int voxel = sectionIndex(x, y, z);
+    const std::vector<uint64_t> &bits = opaque.empty() ? occupied : opaque;
+    return (bits[voxel >> 6] >> (voxel & 63)) & 1;
+}
+
+// With x fastest a row is 16 neighbouring bits of one word, the other
+// layouts gather it bit by bit
+static_assert(CHUNK_SIZE == 16, "section rows are a uint16_t with a bit per voxel along x");
+inline uint16_t ChunkSection::bitmapRow(const std::vector<uint64_t> &bits, int y, int z)
+{
+#if VOXEL_LAYOUT == VOXEL_LAYOUT_XYZ
+    unsigned int voxel = sectionIndex(0, y, z);
+    return (uint16_t)(bits[voxel >> 6] >> (voxel & 63));
+#else
+    uint16_t row = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        unsigned int voxel = sectionIndex(x, y, z);
+        row |= (uint16_t)((bits[voxel >> 6] >> (voxel & 63)) & 1) << x;
+    }
+    return row;
+#endif
+}
+
+inline uint16_t ChunkSection::occupiedRow(int y, int z) const
+{
+    if (bitsPerBlock == 0)
+        return palette[0] != BLOCK::AIR_BLOCK ? 0xFFFF : 0;
+    return bitmapRow(occupied, y, z);
+}
+
+inline uint16_t ChunkSection::opaqueRow(int y, int z) const
+{
+    if (bitsPerBlock == 0)
+        return isOpaqueBlock(palette[0]) ? 0xFFFF : 0;
+    return bitmapRow(opaque.empty() ? occupied : opaque, y, z);
+}
+
+inline bool ChunkStorage::isOccupied(int x, int y, int z) const
+{
+    return sections[y / SECTION_HEIGHT].isOccupied(x, y % SECTION_HEIGHT, z);
+}
+
+inline bool ChunkStorage::isOpaque(int x, int y, int z) const
+{
+    return sections[y / SECTION_HEIGHT].isOpaque(x, y % SECTION_HEIGHT, z);
+}
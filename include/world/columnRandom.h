@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// Counter based random numbers for decorating a column of the world. Every
+// value is a hash of the seed, the column's world coordinates and how many
+// values were drawn before it. Nothing is shared between columns or threads,
+// so a chunk gets the same trees whichever thread generates it and whatever
+// was generated before it.
+class ColumnRandom
+{
+public:
+    ColumnRandom(uint32_t seed, int worldX, int worldZ) : counter(0)
+    {
+        key = mix(((uint64_t)seed << 32) | (uint32_t)worldX);
+        key = mix(key ^ (uint32_t)worldZ);
+    }
+
+    // Uniform in [0, 1)
+    float nextFloat()
+    {
+        counter++;
+        return (mix(key + counter * 0x9e3779b97f4a7c15ull) >> 40) * (1.0f / (1 << 24));
+    }
+
+private:
+    uint64_t key;
+    uint64_t counter;
+
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t v)
+    {
+        v ^= v >> 30;
+        v *= 0xbf58476d1ce4e5b9ull;
+        v ^= v >> 27;
+        v *= 0x94d049bb133111ebull;
+        v ^= v >> 31;
+        return v;
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "world/chunkPos.h"
+#include "world/chunkData.h"
+#include "block.h"
+
+// Sparse record of the blocks the player placed or broke, per chunk and
+// keyed by the block's local index. Generated terrain can always be rebuilt,
+// so a chunk is fully described by generateChunkData plus a replay of its
+// edits and the journal is all that has to survive for a saved world.
+//
+// Every edit is appended to a log file straight away. load() reads the log
+// back, keeping the last edit per block, and rewrites it compacted.
+class EditJournal
+{
+public:
+    EditJournal(std::string path);
+
+    void load();
+    void record(ChunkPos pos, int x, int y, int z, BLOCK block);
+    bool hasEdits(ChunkPos pos);
+    bool hasEdit(ChunkPos pos, int x, int y, int z);
+    void replay(ChunkPos pos, ChunkStorage &data);
+
+    size_t getEditCount();
+
+private:
+    typedef std::unordered_map<unsigned int, BLOCK> ChunkEdits;
+
+    std::string path;
+    std::mutex journal_mtx;
+    std::unordered_map<ChunkPos, ChunkEdits, ChunkPosHash, ChunkPosEqual> chunkEdits;
+    size_t editCount;
+    std::ofstream log;
+
+    void openLog(std::ios::openmode mode);
+    void writeRecord(std::ofstream &out, ChunkPos pos, unsigned int index, BLOCK block);
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include <rendering.h>
 #include <glad/glad.h>
@@ -22,10 +23,10 @@ public:
 
         bind();
 
-        GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0));
+        GLCall(glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, position)));
         GLCall(glEnableVertexAttribArray(0));
 
-        GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)sizeof(glm::vec3)));
+        GLCall(glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, texture)));
         GLCall(glEnableVertexAttribArray(1));
 
         unbind();
@@ -33,7 +34,7 @@ public:
 
     void draw()
     {
-        if (indices.size() <= 0)
+        if (vertices.size() <= 0)
             return;
         bind();
         if (!depth_test)
@@ -42,6 +43,7 @@ public:
         }
 
         GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices.front(), GL_STATIC_DRAW));
+        fillQuadIndices(indices, vertices.size() / 4);
         GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices.front(), GL_STATIC_DRAW));
         GLCall(glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void *)0));
         if (!depth_test)
@@ -54,7 +56,6 @@ public:
     void reset()
     {
         vertices = {};
-        indices = {};
     }
 
     void setDepthTest(bool setter)
@@ -63,9 +64,9 @@ public:
     }
 
     std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
 
 private:
+    std::vector<unsigned int> indices;
     unsigned int VBO, EBO, VAO;
     bool depth_test = true;
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "world/chunkPos.h"
+#include "world/chunkData.h"
+
+#define REGION_SIZE 32
+#define CHUNKS_PER_REGION (REGION_SIZE * REGION_SIZE)
+// Version 1 chunks are stored as plain serialized sections, version 2
+// chunks go through the chunk codec
+#define REGION_FORMAT_VERSION 2
+// How long the writer waits before trying chunks that failed to write again
+#define REGION_RETRY_SECONDS 5
+
+// On disk store for chunks that were evicted from memory. Chunks are grouped
+// into region files of REGION_SIZE x REGION_SIZE chunks. Each file starts
+// with an offset table holding the byte offset and size of every chunk in
+// it, followed by the serialized chunks. A rewritten chunk is appended and
+// its table entry repointed. The dead space this leaves behind is compacted
+// away when the store is closed.
+//
+// save() only queues the snapshot, a background thread does the writing.
+// saveEncoded() queues a chunk that already went through the chunk codec.
+// Chunks waiting to be written are served straight from the queue, and
+// a chunk that fails to write stays queued until a later try succeeds.
+class RegionStore
+{
+public:
+    RegionStore(std::string directory);
+    ~RegionStore();
+
+    void save(ChunkPos pos, ChunkSnapshot data);
+    void saveEncoded(ChunkPos pos, std::vector<uint8_t> encoded);
+    ChunkSnapshot load(ChunkPos pos);
+    void flush();
+
+    bool isClean(ChunkPos pos, const ChunkSnapshot &data);
+    void markClean(ChunkPos pos, const ChunkSnapshot &data);
+
+    size_t getChunksWritten() const;
+    size_t getBytesWritten() const;
+
+private:
+    struct RegionEntry
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct PendingChunk
+    {
+        ChunkSnapshot data;
+        // Set instead of data for chunks queued through saveEncoded()
+        std::shared_ptr<const std::vector<uint8_t>> encoded;
+    };
+
+    std::string directory;
+
+    std::mutex queue_mtx;
+    std::condition_variable queueCondition;
+    std::condition_variable idleCondition;
+    std::unordered_map<ChunkPos, PendingChunk, ChunkPosHash, ChunkPosEqual> pending;
+    // Snapshots that match what is already on disk, saving them again is a no-op
+    std::unordered_map<ChunkPos, std::weak_ptr<const ChunkStorage>, ChunkPosHash, ChunkPosEqual> cleanSnapshots;
+    // Queued chunks whose last write failed
+    std::unordered_set<ChunkPos, ChunkPosHash, ChunkPosEqual> failed;
+    bool writing;
+    bool stop;
+
+    std::mutex file_mtx;
+    // Read only descriptors of the region files loaded from, kept open
+    std::unordered_map<std::string, int> readFiles;
+    std::unordered_set<std::string> writtenRegions;
+    std::atomic<size_t> chunksWritten;
+    std::atomic<size_t> bytesWritten;
+
+    std::thread writer;
+
+    void writerLoop();
+    bool writeChunk(ChunkPos pos, const PendingChunk &chunk);
+    bool readChunk(ChunkPos pos, std::vector<uint8_t> &out);
+    void closeReadFile(const std::string &path);
+    void compactRegion(const std::string &path);
+    std::string regionPath(ChunkPos pos) const;
+};
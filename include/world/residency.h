@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "world/chunkPos.h"
+#include "world/chunkGrid.h"
+
+#define DEFAULT_CHUNK_MEMORY_BUDGET (512ull * 1024 * 1024)
+#define EVICTION_RATE_WINDOW 5
+
+// Where the bytes of a chunk live. Data is the uncompressed snapshot, cold is
+// the encoded copy in the cold tier, mesh is the CPU side vertex vectors and
+// GPU is what was uploaded to buffers.
+enum ResidencyTier
+{
+    DATA_TIER = 0,
+    COLD_TIER,
+    MESH_TIER,
+    GPU_TIER,
+    TIER_COUNT
+};
+
+typedef struct
+{
+    size_t chunks[TIER_COUNT];
+    size_t bytes[TIER_COUNT];
+    size_t totalBytes;
+    size_t budget;
+    size_t evictions;
+    float evictionsPerSecond;
+} ResidencyStats;
+
+// Byte accounting and last access times for every resident chunk, used to
+// keep the world within a memory budget. The world reports every change in
+// a chunk's footprint with setBytes and every use with touch. Eviction
+// itself is done by the world, which asks for candidates in least recently
+// used order.
+class ChunkResidency
+{
+public:
+    ChunkResidency(int radius, size_t budget);
+
+    void setBudget(size_t budget);
+    size_t getBudget();
+    bool isOverBudget();
+    size_t bytesOverBudget();
+
+    void setBytes(ChunkPos pos, ResidencyTier tier, size_t bytes);
+    void touch(ChunkPos pos);
+    void countEviction();
+
+    // Resident chunks further than keepRadius from center, oldest first
+    std::vector<ChunkPos> getEvictionCandidates(ChunkPos center, int keepRadius);
+    size_t getBytes(ChunkPos pos, ResidencyTier tier);
+    ResidencyStats getStats();
+
+private:
+    struct Entry
+    {
+        size_t bytes[TIER_COUNT] = {};
+        uint64_t lastAccess = 0;
+    };
+
+    std::mutex residency_mtx;
+    ChunkGrid<Entry> entries;
+    size_t tierBytes[TIER_COUNT];
+    size_t tierChunks[TIER_COUNT];
+    size_t budget;
+    uint64_t accessClock;
+
+    size_t evictions;
+    std::deque<std::chrono::steady_clock::time_point> recentEvictions;
+
+    void dropOldEvictions();
+    void forget(Entry &entry);
+};
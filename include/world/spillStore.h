@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "world/chunkPos.h"
+#include "block.h"
+
+#define SPILL_SHARDS 16
+#define SPILL_TTL_SECONDS 120
+#define DEFAULT_SPILL_MAX_BLOCKS (256 * 1024)
+
+typedef struct
+{
+    size_t chunks;
+    size_t blocks;
+    size_t maxBlocks;
+    size_t dropped; // blocks thrown away by cleanup so far
+} SpillStats;
+
+// Structure blocks waiting for a chunk that isn't decorated yet. Chunks are
+// spread over SPILL_SHARDS maps by position. A shard's lock only covers
+// finding or creating a chunk's list. The blocks themselves are pushed onto
+// the list with a compare and swap and taken off with a single exchange, so
+// decorations writing into the same chunk never wait on each other.
+//
+// Every method can be called from any thread without outside locks. take
+// and cleanup retire a list before dropping it, and an append that finds
+// its list retired starts over on a fresh one, so no blocks are lost to a
+// list that was just removed. The store doesn't order an append against a
+// take for the same chunk. World keeps blocks from arriving after a chunk
+// took its spills by calling both for a chunk only under data_mtx.
+//
+// Nothing is kept forever. cleanup drops the lists of chunks outside the
+// kept radius once nothing was appended to them for the TTL, and while the
+// store holds more than maxBlocks it drops the furthest lists outside the
+// radius regardless of age.
+class SpillStore
+{
+public:
+    SpillStore(size_t maxBlocks);
+    ~SpillStore();
+
+    void append(ChunkPos pos, const BlockWithPos *blocks, size_t count);
+    // Removes and returns everything pending for the chunk, oldest first
+    std::vector<BlockWithPos> take(ChunkPos pos);
+    bool hasPending(ChunkPos pos);
+
+    void cleanup(ChunkPos center, int keepRadius, std::chrono::seconds ttl);
+    SpillStats getStats();
+
+private:
+    struct Node
+    {
+        BlockWithPos block;
+        Node *next;
+    };
+
+    // head is &retired once the list was taken or dropped, nothing can be
+    // pushed onto it after that
+    struct List
+    {
+        SpillStore *store;
+        std::atomic<Node *> head{nullptr};
+        std::atomic<int64_t> lastAppend{0};
+
+        List(SpillStore *store) : store(store) {}
+        ~List();
+    };
+
+    struct Shard
+    {
+        std::mutex shard_mtx;
+        std::unordered_map<ChunkPos, std::shared_ptr<List>, ChunkPosHash, ChunkPosEqual> lists;
+    };
+
+    Shard shards[SPILL_SHARDS];
+    size_t maxBlocks;
+    std::atomic<size_t> blockCount;
+    std::atomic<size_t> droppedCount;
+
+    static Node retired;
+
+    Shard &shardFor(ChunkPos pos);
+    static size_t freeNodes(Node *node);
+    void drop(List &list);
+};
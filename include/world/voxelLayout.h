@@ -0,0 +1,42 @@
+#pragma once
+
+#include "world/chunkData.h"
+
+// Order of the voxels inside a 16x16x16 section. Every packed index and
+// bitmap bit goes through sectionIndex, so the layout is picked at build
+// time with -DVOXEL_LAYOUT=... (VOXWRLD_VOXEL_LAYOUT in CMake). Serialized
+// sections always use the XYZ order so region files do not depend on it.
+#define VOXEL_LAYOUT_XYZ 0    // x fastest, then y, then z
+#define VOXEL_LAYOUT_COLUMN 1 // y fastest, every column is contiguous
+#define VOXEL_LAYOUT_MORTON 2 // bits of x, y and z interleaved
+
+#ifndef VOXEL_LAYOUT
+#define VOXEL_LAYOUT VOXEL_LAYOUT_XYZ
+#endif
+
+#if VOXEL_LAYOUT == VOXEL_LAYOUT_XYZ
+#define VOXEL_LAYOUT_NAME "xyz"
+#elif VOXEL_LAYOUT == VOXEL_LAYOUT_COLUMN
+#define VOXEL_LAYOUT_NAME "column"
+#elif VOXEL_LAYOUT == VOXEL_LAYOUT_MORTON
+#define VOXEL_LAYOUT_NAME "morton"
+#else
+#error "Unknown VOXEL_LAYOUT"
+#endif
+
+// Moves the 4 bits of v to every third bit
+inline unsigned int mortonSpread(unsigned int v)
+{
+    return (v & 1) | ((v & 2) << 2) | ((v & 4) << 4) | ((v & 8) << 6);
+}
+
+inline unsigned int sectionIndex(int x, int y, int z)
+{
+#if VOXEL_LAYOUT == VOXEL_LAYOUT_COLUMN
+    return y + (z * SECTION_HEIGHT) + (x * SECTION_HEIGHT * CHUNK_SIZE);
+#elif VOXEL_LAYOUT == VOXEL_LAYOUT_MORTON
+    return mortonSpread(x) | (mortonSpread(y) << 1) | (mortonSpread(z) << 2);
+#else
+    return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * SECTION_HEIGHT);
+#endif
+}
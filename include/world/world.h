@@ -2,9 +2,16 @@
 
 #include <deque>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 #include "world/chunkData.h"
+#include "world/chunkStorage.h"
 #include "world/chunkMesh.h"
+#include "world/regionStore.h"
+#include "world/editJournal.h"
+#include "world/residency.h"
+#include "world/spillStore.h"
 #include "block.h"
 #include "world/mesh.h"
 #include "threading.h"
@@ -12,7 +19,7 @@
 class World
 {
 public:
-    World() : threadPool(3), dataThreadPool(3)
+    World(size_t generationThreads = std::thread::hardware_concurrency()) : threadPool(3), dataThreadPool(2), chunkDataMap(render_distance + 6), coldChunkMap(render_distance + 6), chunkMeshMap(render_distance + 4), spillStore(DEFAULT_SPILL_MAX_BLOCKS), regionStore("world"), editJournal("world/edits.journal"), residency(render_distance + 6, DEFAULT_CHUNK_MEMORY_BUDGET), generationScheduler(generationThreads)
     {
         focusMesh.setDepthTest(false);
         intialDataGenerated = false;
@@ -21,22 +28,44 @@ public:
     void init();
     void startWorldGeneration();
 
-    void render();
+    // Draws the world relative to the camera, chunkOrigin in the shader is
+    // set per mesh
+    void render(unsigned int shaderId, glm::vec3 cameraPos);
     BLOCK getBlockData(glm::ivec3 blockPos);
+    bool isBlockOccupied(glm::ivec3 blockPos);
+    int getSurfaceHeight(int x, int z);
     void removeBlock(glm::ivec3 blockPos);
     void createBlock(glm::ivec3 blockPos, BLOCK block);
     void updateFocusBlock(glm::ivec3 &pos, char &face);
+
+    void generateChunkData(ChunkPos pos);
+    ChunkSnapshot getChunkDataIfExists(ChunkPos pos);
+    bool collectChunkData(ChunkPos pos, ChunkData &chunkData);
+
+    void setMemoryBudget(size_t bytes);
+    ResidencyStats getResidencyStats();
+    SpillStats getSpillStats();
+    size_t getGenerationThreadCount();
+
+    // For tools that build the world ahead of time
+    void generateChunks(const std::vector<ChunkPos> &positions);
+    void unloadChunkData(ChunkPos pos, bool save);
+    void flushRegionStore();
+    size_t getRegionBytesWritten();
+
     bool intialDataGenerated;
     ChunkPos worldCurrPos;
     std::mutex pos_mtx;
 
 private:
     ThreadPool threadPool;
+    // Only runs the data polling loops, chunks are generated on generationScheduler
     ThreadPool dataThreadPool;
     int chunkGenerationTries = 0;
 
     std::mutex data_mtx;
     ChunkDataMap chunkDataMap;
+    ColdChunkMap coldChunkMap;
 
     std::mutex mesh_mtx;
     ChunkMeshMap chunkMeshMap;
@@ -47,12 +76,32 @@ private:
     std::mutex data_queue_mtx;
     std::deque<ChunkPos> chunkDataQueue;
 
+    // struct_mtx only guards decoratingChunks, the spill store has its own
+    // locking
     std::mutex struct_mtx;
-    StructQueue structQueue;
+    SpillStore spillStore;
+    std::unordered_set<ChunkPos, ChunkPosHash, ChunkPosEqual> decoratingChunks;
+
+    std::mutex generation_mtx;
+    std::unordered_set<ChunkPos, ChunkPosHash, ChunkPosEqual> chunksInGeneration;
 
     std::mutex player_mtx;
 
+    RegionStore regionStore;
+    EditJournal editJournal;
+    ChunkResidency residency;
+
+    // GL objects of dropped meshes, deleted on the render thread
+    std::vector<unsigned int> buffersToDelete;
+    std::vector<unsigned int> vertexArraysToDelete;
+
+    // Element buffer every chunk mesh draws its faces with, only touched on
+    // the render thread
+    unsigned int quadIndexBuffer = 0;
+    size_t quadIndexCapacity = 0;
+
     Mesh focusMesh;
+    glm::ivec3 focusPos;
 
     bool posIsInQueue(std::deque<ChunkPos> &queue, ChunkPos &pos);
 
@@ -61,14 +110,22 @@ private:
     void generateNextData();
 
     void generateChunkDataFromPos(ChunkPos pos, bool initial);
-    void generateChunkData(ChunkPos pos);
-    std::vector<char> &getChunkDataIfExists(ChunkPos pos);
+    void loadOrGenerateChunkData(ChunkPos pos);
+    ChunkSnapshot catchUpStoredChunk(ChunkPos pos, ChunkSnapshot stored);
     bool chunkDataExists(ChunkPos chunkPos);
+    ChunkSnapshot *findChunkData(ChunkPos pos);
+    void insertChunkData(ChunkPos pos, ChunkSnapshot data);
+    void saveColdChunk(ChunkPos pos, ColdChunk &cold);
+    bool freezeChunkData(ChunkPos pos, ChunkSnapshot data);
+    bool evictColdChunk(ChunkPos pos);
+    void enforceMemoryBudget(ChunkPos pos);
+    bool editChunkData(ChunkPos pos, int x, int y, int z, BLOCK block);
 
     void removeChunkDataFromMap(ChunkPos pos);
     void removeUnneededChunkData(ChunkPos pos);
 
     // chunk mesh
+    void reserveQuadIndices(size_t quads);
     void initializeOpaqueChunk(ChunkMesh &chunkMesh);
     void initializeTransparentChunk(ChunkMesh &chunkMesh);
     void bindChunkOpaque(ChunkMesh &chunkMesh);
@@ -76,15 +133,28 @@ private:
     void unbindChunk(ChunkMesh &chunkMesh);
     void addChunksToMeshQueue(ChunkPos pos);
 
-    void renderChunkMeshes();
+    void renderChunkMeshes(int originLoc, glm::vec3 cameraPos);
     void generateNextMesh();
 
     bool chunkMeshExists(ChunkPos pos);
     void removeChunkFromMap(ChunkPos pos);
     void removeUnneededChunkMeshes(ChunkPos pos);
+    void releaseChunkMesh(ChunkMesh &chunkMesh);
+    bool evictChunkMesh(ChunkPos pos);
     ChunkMesh *getChunkFromMap(ChunkPos pos);
 
     // structures
-    void addStructureBlockToWorld(ChunkPos &pos, BlockWithPos &blockWithPos, std::vector<char> &data);
-    void generateStructures(std::vector<char> &data, ChunkPos pos);
+    void generateStructures(const ChunkStorage &data, ChunkPos pos, StructQueue &placements);
+    void queueStructureBlocks(ChunkPos pos, StructQueue &placements, std::vector<ChunkPos> &changed);
+    void applyQueuedStructureBlocks(ChunkStorage &data, ChunkPos pos);
+
+    // generation stages
+    void requestChunkData(ChunkPos pos);
+    void decorateReadyChunks(ChunkPos pos);
+    bool claimDecoration(ChunkPos pos);
+    void decorateChunk(ChunkPos pos);
+    void queueRemeshes(const std::vector<ChunkPos> &changed);
+
+    // Declared last so it is destroyed first, its jobs use everything above
+    TaskScheduler generationScheduler;
 };
\ No newline at end of file
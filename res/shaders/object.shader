@@ -1,24 +1,35 @@
 #shader vertex
 #version 330 core 
-layout (location = 0) in vec3 aPos; 
-layout (location = 1) in vec2 aTexCoord; 
+// Packed vertex, see Vertex in rendering.h
+layout (location = 0) in uint aPosition; 
+layout (location = 1) in uint aTexture; 
 
-out vec2 TexCoord; 
+out vec2 Repeat; 
+flat out vec2 Tile;
 out float fragDistance;
-out vec3 fragWorldPos;
+out vec3 fragPos;
 
-uniform mat4 model; 
+// The origin of the chunk being drawn, relative to the camera
+uniform vec3 chunkOrigin;
 uniform mat4 view; 
 uniform mat4 projection;
 
+// One 16 pixel tile of the 1024 pixel atlas
+const float tileSize = 16.0 / 1024.0;
+const float loweredHeight = 0.1;
+
 void main() 
 { 
-    vec4 worldPos = model * vec4(aPos, 1.0);
-    vec4 viewPos = view * worldPos;
+    vec3 pos = vec3(aPosition & 31u, (aPosition >> 5) & 511u, (aPosition >> 14) & 31u);
+    pos.y -= float((aPosition >> 19) & 1u) * loweredHeight;
+
+    vec4 cameraPos = vec4(chunkOrigin + pos, 1.0);
+    vec4 viewPos = view * cameraPos;
     gl_Position = projection * viewPos;
-    TexCoord = aTexCoord;
+    Tile = vec2(aTexture & 63u, (aTexture >> 6) & 63u) * tileSize;
+    Repeat = vec2((aTexture >> 12) & 31u, (aTexture >> 17) & 31u);
     fragDistance = length(viewPos.xyz);
-    fragWorldPos = worldPos.xyz;
+    fragPos = cameraPos.xyz;
 }
 
 #shader fragment
@@ -26,12 +37,16 @@ void main()
 
 out vec4 FragColor; 
 
-in vec2 TexCoord; 
+in vec2 Repeat; 
+flat in vec2 Tile;
 in float fragDistance;
-in vec3 fragWorldPos;
+in vec3 fragPos;
 
 uniform sampler2D ourTexture;
 
+// One 16 pixel tile of the 1024 pixel atlas
+const float tileSize = 16.0 / 1024.0;
+
 // Fog parameters
 const vec3 fogColor = vec3(0.6, 0.7, 0.8);  // Light blue-gray fog
 const float fogStart = 100.0;                 // Distance where fog starts
@@ -44,10 +59,12 @@ const float diffuseStrength = 0.4;                      // How strong the direct
 
 void main() 
 { 
-    vec4 texColor = texture(ourTexture, TexCoord);
+    // Merged faces repeat their tile once per block
+    vec2 atlasCoord = Tile + fract(Repeat) * tileSize;
+    vec4 texColor = texture(ourTexture, atlasCoord);
     
     // Calculate fake normal from fragment derivatives (flat shading for blocks)
-    vec3 normal = normalize(cross(dFdx(fragWorldPos), dFdy(fragWorldPos)));
+    vec3 normal = normalize(cross(dFdx(fragPos), dFdy(fragPos)));
     
     // Simple directional lighting
     float diff = max(dot(normal, lightDir), 0.0);
@@ -1,228 +1,78 @@
 #include "block.h"
 
-void renderLiquidBlock(LiquidRenderInfo &renderInfo)
+void emitFace(int face, glm::ivec3 origin, int w, int h, const UVcoords &coords, bool lowered, std::vector<Vertex> &vertices)
 {
-    std::vector<UVcoords> textureCoords = blockTextureCoords[renderInfo.block];
-    UVcoords coords = textureCoords[0];
-
-    float topOffset = renderInfo.liquidOnTop ? 0.0f : 0.1f;
-
-    // North face
-    if ((renderInfo.cover & 1) == 1)
+    // Corner offsets from the origin and how often the tile repeated up to
+    // each corner
+    int corners[4][3];
+    int repeats[4][2];
+    switch (face)
     {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(coords.u1, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u1, coords.v2)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
+    case 1: // North
+        corners[0][0] = 0, corners[0][1] = 0, corners[0][2] = 0, repeats[0][0] = 0, repeats[0][1] = 0;
+        corners[1][0] = w, corners[1][1] = 0, corners[1][2] = 0, repeats[1][0] = w, repeats[1][1] = 0;
+        corners[2][0] = w, corners[2][1] = h, corners[2][2] = 0, repeats[2][0] = w, repeats[2][1] = h;
+        corners[3][0] = 0, corners[3][1] = h, corners[3][2] = 0, repeats[3][0] = 0, repeats[3][1] = h;
+        break;
+    case 2: // South
+        corners[0][0] = 0, corners[0][1] = h, corners[0][2] = 1, repeats[0][0] = 0, repeats[0][1] = h;
+        corners[1][0] = w, corners[1][1] = h, corners[1][2] = 1, repeats[1][0] = w, repeats[1][1] = h;
+        corners[2][0] = w, corners[2][1] = 0, corners[2][2] = 1, repeats[2][0] = w, repeats[2][1] = 0;
+        corners[3][0] = 0, corners[3][1] = 0, corners[3][2] = 1, repeats[3][0] = 0, repeats[3][1] = 0;
+        break;
+    case 4: // West
+        corners[0][0] = 0, corners[0][1] = 0, corners[0][2] = w, repeats[0][0] = 0, repeats[0][1] = 0;
+        corners[1][0] = 0, corners[1][1] = 0, corners[1][2] = 0, repeats[1][0] = w, repeats[1][1] = 0;
+        corners[2][0] = 0, corners[2][1] = h, corners[2][2] = 0, repeats[2][0] = w, repeats[2][1] = h;
+        corners[3][0] = 0, corners[3][1] = h, corners[3][2] = w, repeats[3][0] = 0, repeats[3][1] = h;
+        break;
+    case 8: // East
+        corners[0][0] = 1, corners[0][1] = h, corners[0][2] = w, repeats[0][0] = 0, repeats[0][1] = h;
+        corners[1][0] = 1, corners[1][1] = h, corners[1][2] = 0, repeats[1][0] = w, repeats[1][1] = h;
+        corners[2][0] = 1, corners[2][1] = 0, corners[2][2] = 0, repeats[2][0] = w, repeats[2][1] = 0;
+        corners[3][0] = 1, corners[3][1] = 0, corners[3][2] = w, repeats[3][0] = 0, repeats[3][1] = 0;
+        break;
+    case 16: // Bottom
+        corners[0][0] = 0, corners[0][1] = 0, corners[0][2] = h, repeats[0][0] = 0, repeats[0][1] = 0;
+        corners[1][0] = w, corners[1][1] = 0, corners[1][2] = h, repeats[1][0] = w, repeats[1][1] = 0;
+        corners[2][0] = w, corners[2][1] = 0, corners[2][2] = 0, repeats[2][0] = w, repeats[2][1] = h;
+        corners[3][0] = 0, corners[3][1] = 0, corners[3][2] = 0, repeats[3][0] = 0, repeats[3][1] = h;
+        break;
+    default: // Top
+        corners[0][0] = 0, corners[0][1] = 1, corners[0][2] = 0, repeats[0][0] = 0, repeats[0][1] = h;
+        corners[1][0] = w, corners[1][1] = 1, corners[1][2] = 0, repeats[1][0] = w, repeats[1][1] = h;
+        corners[2][0] = w, corners[2][1] = 1, corners[2][2] = h, repeats[2][0] = w, repeats[2][1] = 0;
+        corners[3][0] = 0, corners[3][1] = 1, corners[3][2] = h, repeats[3][0] = 0, repeats[3][1] = 0;
+        break;
     }
-    // South face
-    if ((renderInfo.cover & 2) == 2)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u1, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(coords.u1, coords.v1)});
 
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-    // West face
-    if ((renderInfo.cover & 4) == 4)
+    for (int i = 0; i < 4; i++)
     {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(coords.u1, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u1, coords.v2)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
+        // Only the upper corners come down with a lowered face
+        vertices.push_back(packVertex(origin.x + corners[i][0], origin.y + corners[i][1], origin.z + corners[i][2], lowered && corners[i][1] > 0,
+                                      coords.col, coords.row, repeats[i][0], repeats[i][1]));
     }
-    // East face
-    if ((renderInfo.cover & 8) == 8)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u1, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(coords.u1, coords.v1)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
+}
 
-        renderInfo.indiceOffset += 4;
-    }
-    // Bottom face
-    if ((renderInfo.cover & 16) == 16)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(coords.u1, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(coords.u1, coords.v2)});
+void renderLiquidBlock(LiquidRenderInfo &renderInfo)
+{
+    const UVcoords &coords = blockProperties[renderInfo.block].textures[0];
 
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
+    // The surface sits a little below the top of the block
+    bool lowered = !renderInfo.liquidOnTop;
 
-        renderInfo.indiceOffset += 4;
-    }
-    // Top face
-    if ((renderInfo.cover & 32) == 32)
+    for (int face = 1; face <= 32; face <<= 1)
     {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u1, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 0.0f), glm::vec2(coords.u2, coords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u2, coords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f - topOffset, 1.0f), glm::vec2(coords.u1, coords.v1)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
+        if ((renderInfo.cover & face) == face)
+            emitFace(face, renderInfo.blockPos, 1, 1, coords, lowered, renderInfo.chunkVertices);
     }
 }
 
 void renderRegularBlock(BlockRenderInfo &renderInfo)
 {
-    std::vector<UVcoords> textureCoords = blockTextureCoords[renderInfo.block];
-    UVcoords bottomTexCoords = textureCoords[0];
-    UVcoords sideTexCoords = textureCoords[1];
-    UVcoords topTexCoords = textureCoords[2];
-
-    // North face
-    if ((renderInfo.cover & 1) == 1)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v2)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-    // South face
-    if ((renderInfo.cover & 2) == 2)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v1)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-    // West face
-    if ((renderInfo.cover & 4) == 4)
+    for (int face = 1; face <= 32; face <<= 1)
     {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v2)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-    // East face
-    if ((renderInfo.cover & 8) == 8)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(sideTexCoords.u2, sideTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(sideTexCoords.u1, sideTexCoords.v1)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
+        if ((renderInfo.cover & face) == face)
+            emitFace(face, renderInfo.blockPos, 1, 1, blockFaceTexture(renderInfo.block, face), false, renderInfo.chunkVertices);
     }
-    // Bottom face
-    if ((renderInfo.cover & 16) == 16)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(bottomTexCoords.u1, bottomTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(bottomTexCoords.u2, bottomTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(bottomTexCoords.u2, bottomTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(bottomTexCoords.u1, bottomTexCoords.v2)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-    // Top face
-    if ((renderInfo.cover & 32) == 32)
-    {
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(topTexCoords.u1, topTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(topTexCoords.u2, topTexCoords.v2)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(topTexCoords.u2, topTexCoords.v1)});
-        renderInfo.chunkVertices.push_back({renderInfo.blockPos + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(topTexCoords.u1, topTexCoords.v1)});
-
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 1);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 2);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 3);
-        renderInfo.chunkIndices.push_back(renderInfo.indiceOffset + 0);
-
-        renderInfo.indiceOffset += 4;
-    }
-}
-
-void renderAirBlock(BlockRenderInfo &renderInfo)
-{
-    return;
 }
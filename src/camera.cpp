@@ -45,6 +45,7 @@ Camera::Camera(int screenwidth, int screenHeight, World *worldPtr)
     speedMode = false;
     height = 1.4f;
     isJumping = false;
+    spawned = false;
 
     Id = curr_cam_id;
     curr_cam_id++;
@@ -88,6 +89,16 @@ void Camera::tick(float currentTime)
     direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     cameraFront = glm::normalize(direction);
 
+    // Hold still until the chunk below has been generated, then stand on its surface
+    if (!spawned)
+    {
+        int surface = world->getSurfaceHeight((int)std::floor(cameraPos.x), (int)std::floor(cameraPos.z));
+        if (surface < 0)
+            return;
+        cameraPos.y = surface + 1 + height;
+        spawned = true;
+    }
+
     // std::cout << "front: (" << cameraFront.x << ", " << cameraFront.y << ", " << cameraFront.z << ") " << std::endl;
     // std::cout << "pos: (" << cameraPos.x << ", \t\t" << cameraPos.y << ", \t\t" << cameraPos.z << ") " << std::endl;
 
@@ -123,7 +123,7 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 
 void playerHitBlock(BLOCK block, glm::ivec3 &pos, char &face)
 {
-    if (isLiquid(block))
+    if (!blockProperties[block].solid)
         return;
     world->removeBlock(pos);
 }
@@ -259,6 +259,13 @@ int main(void)
 
     world->init();
 
+    // VOXWRLD_MEMORY_MB caps the memory used by chunk data and meshes
+    const char *memoryBudget = getenv("VOXWRLD_MEMORY_MB");
+    if (memoryBudget)
+    {
+        world->setMemoryBudget(strtoull(memoryBudget, nullptr, 10) * 1024 * 1024);
+    }
+
     // Timing variables
     auto startTime = std::chrono::high_resolution_clock::now();
     int frameCount = 0;
@@ -273,12 +280,22 @@ int main(void)
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         // Create an ImGui window for displaying the FPS
-        ImGui::SetNextWindowSize(ImVec2(450.0f, 200.0f));
+        ImGui::SetNextWindowSize(ImVec2(640.0f, 360.0f));
         ImGui::Begin("Voxworld Alpha 0.0.1");
         ImGui::Text("FPS: %.1f", fps); // Display the FPS
         auto playerPos = player->getPos();
         ImGui::Text("Pos: (%.2f, %.2f, %.2f)", playerPos.x, playerPos.y, playerPos.z);
-        ImGui::Text("Currently Selected Block: %s", blockNames[allowedBlocks[currBlockIdx]].c_str());
+        ImGui::Text("Currently Selected Block: %s", blockProperties[allowedBlocks[currBlockIdx]].name);
+
+        ResidencyStats residency = world->getResidencyStats();
+        float mib = 1024.0f * 1024.0f;
+        ImGui::Text("Chunks: %zu data, %zu cold, %zu meshes", residency.chunks[DATA_TIER], residency.chunks[COLD_TIER], residency.chunks[MESH_TIER]);
+        ImGui::Text("Memory: %.1f / %.0f MiB", residency.totalBytes / mib, residency.budget / mib);
+        ImGui::Text("  data %.1f, cold %.1f, mesh %.1f, gpu %.1f MiB", residency.bytes[DATA_TIER] / mib, residency.bytes[COLD_TIER] / mib, residency.bytes[MESH_TIER] / mib, residency.bytes[GPU_TIER] / mib);
+        ImGui::Text("Evictions: %zu (%.1f/s)", residency.evictions, residency.evictionsPerSecond);
+
+        SpillStats spills = world->getSpillStats();
+        ImGui::Text("Spilled blocks: %zu / %zu in %zu chunks, %zu dropped", spills.blocks, spills.maxBlocks, spills.chunks, spills.dropped);
         ImGui::End();
 
         frameCount++;
@@ -292,8 +309,10 @@ int main(void)
         GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
         GLCall(glClearColor(0.2f, 0.65f, 1.0f, 1.0f));
 
-        // view
+        // view, without the camera's translation. The world is drawn relative
+        // to the camera instead, see World::render
         glm::mat4 view = player->getView();
+        view[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
         int viewLoc = glGetUniformLocation(shader.Id, "view");
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
 
@@ -308,11 +327,6 @@ int main(void)
         int projectionLoc = glGetUniformLocation(shader.Id, "projection");
         glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
-        glm::mat4 model;
-        model = glm::mat4(1.0f);
-        int modelLoc = glGetUniformLocation(shader.Id, "model");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
         auto playerfront = player->getFront();
         // std::cout << "front: (" << playerfront.x << ", " << playerfront.y << ", " << playerfront.z << ") " << std::endl;
 
@@ -320,7 +334,7 @@ int main(void)
         RayCastInfo info = {*world, player->getPos(), player->getFront(), 5.0f, focusBlock};
         shoot_ray(info);
 
-        world->render();
+        world->render(shader.Id, player->getPos());
 
         // Rendering
         // (Your code clears your framebuffer, renders your other stuff etc.)
@@ -51,9 +51,10 @@ bool shoot_ray(RayCastInfo &info)
     while (distanceTraveled <= info.maxDistance)
     {
         // Check the block data at the current position
-        BLOCK block = info.world.getBlockData(blockPos);
-        if (block != BLOCK::AIR_BLOCK)
+        if (info.world.isBlockOccupied(blockPos))
         {
+            BLOCK block = info.world.getBlockData(blockPos);
+
             // Calculate the exact intersection point
             glm::vec3 intersectionPoint = info.origin + info.rayDir * distanceTraveled;
 
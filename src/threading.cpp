@@ -1,6 +1,9 @@
 
 #include "threading.h"
 
+#include <algorithm>
+#include <exception>
+
 // Constructor
 ThreadPool::ThreadPool(size_t numThreads) : stop(false)
 {
@@ -41,3 +44,172 @@ ThreadPool::~ThreadPool()
         worker.join();
     }
 }
+
+// The scheduler and worker the current thread belongs to, if any
+static thread_local TaskScheduler *currentScheduler = nullptr;
+static thread_local size_t currentWorker = 0;
+
+TaskScheduler::TaskScheduler(size_t numThreads) : queuedCount(0), nextQueue(0), stop(false)
+{
+    numThreads = std::max<size_t>(numThreads, 1);
+    for (size_t i = 0; i < numThreads; i++)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < numThreads; i++)
+    {
+        workers.emplace_back([this, i]
+                             { workerLoop(i); });
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::unique_lock<std::mutex> lock(sleep_mtx);
+        stop = true;
+    }
+    condition.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Workers push onto their own deque, everyone else spreads the tasks over
+// the deques in turn
+void TaskScheduler::push(std::function<void()> task, bool urgent)
+{
+    size_t target = currentScheduler == this ? currentWorker : nextQueue++ % queues.size();
+
+    // Counted before it is visible, so a worker never sees a task it can't
+    // account for
+    queuedCount++;
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->deque_mtx);
+        if (urgent)
+            queues[target]->tasks.push_front(std::move(task));
+        else
+            queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mtx);
+    }
+    condition.notify_one();
+}
+
+// Runs the next task of the worker's own deque or else steals one from the
+// deques after it. Returns false when every deque was empty.
+bool TaskScheduler::runOne(size_t self)
+{
+    std::function<void()> task;
+    for (size_t i = 0; i < queues.size() && !task; i++)
+    {
+        WorkerQueue &queue = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.deque_mtx);
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+
+    if (!task)
+        return false;
+
+    queuedCount--;
+    task();
+    return true;
+}
+
+void TaskScheduler::workerLoop(size_t index)
+{
+    currentScheduler = this;
+    currentWorker = index;
+    while (true)
+    {
+        if (runOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mtx);
+        condition.wait(lock, [this]
+                       { return stop || queuedCount > 0; });
+        if (stop && queuedCount == 0)
+            return;
+    }
+}
+
+// The parts are claimed from a shared counter rather than queued one by one.
+// Helpers that only get to run after the caller took every part find nothing
+// left and return right away, and the caller never waits on a part that
+// nobody started. While other threads finish their parts the caller runs
+// queued tasks, and sleeps once there are none. A part that throws still
+// counts as done, the first exception is rethrown to the caller.
+void TaskScheduler::parallelFor(int count, const std::function<void(int)> &body)
+{
+    struct Job
+    {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        int count;
+        const std::function<void(int)> *body;
+
+        std::mutex done_mtx;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->count = count;
+    job->body = &body;
+    auto work = [job]
+    {
+        int part;
+        while ((part = job->next++) < job->count)
+        {
+            try
+            {
+                (*job->body)(part);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job->done_mtx);
+                if (!job->error)
+                    job->error = std::current_exception();
+            }
+
+            if (++job->done == job->count)
+            {
+                std::lock_guard<std::mutex> lock(job->done_mtx);
+                job->finished.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min<int>(count, queues.size()) - 1;
+    for (int i = 0; i < helpers; i++)
+    {
+        push(work, true);
+    }
+    work();
+
+    // Only parts that other threads are in the middle of are left
+    size_t self = currentScheduler == this ? currentWorker : 0;
+    while (job->done < count)
+    {
+        if (runOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(job->done_mtx);
+        job->finished.wait(lock, [&]
+                           { return job->done == count || queuedCount > 0; });
+    }
+
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
+
+size_t TaskScheduler::getThreadCount() const
+{
+    return workers.size();
+}
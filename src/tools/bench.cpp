@@ -0,0 +1,1163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "world/world.h"
+#include "world/chunkData.h"
+#include "world/chunkStorage.h"
+#include "world/chunkMesh.h"
+#include "world/chunkGrid.h"
+#include "world/chunkCodec.h"
+#include "world/regionStore.h"
+#include "world/voxelLayout.h"
+#include "world/batchNoise.h"
+#include "world/spillStore.h"
+#include "physics.h"
+
+// Generates every chunk in the square of the given radius around the origin
+void generateRegion(World &world, int radius)
+{
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            world.generateChunkData({x, z});
+        }
+    }
+}
+
+void benchStorage(World &world, int radius)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    generateRegion(world, radius);
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t chunks = 0;
+    size_t packedBytes = 0;
+    size_t emptySections = 0;
+    size_t uniformSections = 0;
+    size_t bitmapMismatches = 0;
+    size_t heightMismatches = 0;
+    size_t decorated = 0;
+    std::map<int, int> bitsHistogram;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            ChunkSnapshot data = world.getChunkDataIfExists({x, z});
+            chunks++;
+            packedBytes += data->memoryUsage();
+            decorated += data->getStage() == DECORATED_STAGE;
+            for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+            {
+                const ChunkSection &section = data->getSection(i);
+                if (section.isUniform())
+                {
+                    uniformSections++;
+                    emptySections += section.isEmpty();
+                }
+                else
+                {
+                    bitsHistogram[section.getBitsPerBlock()]++;
+                }
+            }
+
+            // The occupancy bitmaps have to agree with the palette
+            for (int bx = 0; bx < CHUNK_SIZE; bx++)
+            {
+                for (int by = 0; by < CHUNK_HEIGHT; by++)
+                {
+                    for (int bz = 0; bz < CHUNK_SIZE; bz++)
+                    {
+                        BLOCK block = data->get(bx, by, bz);
+                        bitmapMismatches += data->isOccupied(bx, by, bz) != (block != BLOCK::AIR_BLOCK) ||
+                                            data->isOpaque(bx, by, bz) != isOpaqueBlock(block);
+                    }
+                }
+            }
+
+            // and the heightmap with a top down scan of every column
+            for (int bx = 0; bx < CHUNK_SIZE; bx++)
+            {
+                for (int bz = 0; bz < CHUNK_SIZE; bz++)
+                {
+                    int height = CHUNK_HEIGHT - 1;
+                    while (height >= 0 && data->get(bx, height, bz) == BLOCK::AIR_BLOCK)
+                        height--;
+                    heightMismatches += data->getHeight(bx, bz) != height;
+                }
+            }
+        }
+    }
+
+    size_t rawBytes = chunks * (BLOCKS_PER_CHUNK);
+    size_t sections = chunks * SECTIONS_PER_CHUNK;
+    std::cout << "chunks generated:      " << chunks << " in " << elapsed.count() << "s, " << decorated << " decorated" << std::endl;
+    std::cout << "raw bytes per chunk:   " << (BLOCKS_PER_CHUNK) << std::endl;
+    std::cout << "packed bytes per chunk: " << packedBytes / chunks << std::endl;
+    std::cout << "total raw / packed:    " << rawBytes / 1024 << " KiB / " << packedBytes / 1024 << " KiB" << std::endl;
+    std::cout << "uniform sections:      " << uniformSections << " of " << sections << " (" << emptySections << " empty)" << std::endl;
+    for (const auto &pair : bitsHistogram)
+    {
+        std::cout << "  " << pair.first << " bits per block: " << pair.second << " sections" << std::endl;
+    }
+    std::cout << "bitmap mismatches:     " << bitmapMismatches << std::endl;
+    std::cout << "heightmap mismatches:  " << heightMismatches << std::endl;
+}
+
+// Area of the opaque quads of a mesh in block faces, the same for both
+// meshers when the greedy one covers exactly the faces the per face one emits
+double opaqueFaceArea(const ChunkMesh &chunkMesh)
+{
+    double area = 0;
+    for (size_t i = 0; i + 3 < chunkMesh.vertices_opaque.size(); i += 4)
+    {
+        glm::vec3 corners[4];
+        for (int j = 0; j < 4; j++)
+        {
+            UnpackedVertex vertex = unpackVertex(chunkMesh.vertices_opaque[i + j]);
+            corners[j] = glm::vec3(vertex.x, vertex.y, vertex.z);
+        }
+        area += glm::length(glm::cross(corners[1] - corners[0], corners[3] - corners[0]));
+    }
+    return area;
+}
+
+void benchMesh(World &world, int radius)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    generateRegion(world, radius);
+    std::chrono::duration<double> generateElapsed = std::chrono::high_resolution_clock::now() - start;
+    int generatedChunks = (2 * radius + 1) * (2 * radius + 1);
+    std::cout << "generate: " << generatedChunks << " chunks, " << generateElapsed.count() * 1000.0 / generatedChunks << " ms per chunk" << std::endl;
+
+    // Both meshers over the same chunks, per face first
+    double faceArea[2] = {0, 0};
+    for (int pass = 0; pass < 2; pass++)
+    {
+        greedy_meshing = pass == 1;
+
+        // only the interior has all four neighbours available
+        size_t chunks = 0;
+        size_t vertices = 0;
+        size_t largestQuads = 0;
+        size_t opaqueVertices = 0;
+        size_t bytes = 0;
+        std::chrono::duration<double> collectElapsed(0);
+        std::chrono::duration<double> meshElapsed(0);
+        for (int x = -radius + 1; x < radius; x++)
+        {
+            for (int z = -radius + 1; z < radius; z++)
+            {
+                // collectChunkData is the part of a mesh job that holds data_mtx
+                ChunkData chunkData;
+                start = std::chrono::high_resolution_clock::now();
+                world.collectChunkData({x, z}, chunkData);
+                collectElapsed += std::chrono::high_resolution_clock::now() - start;
+
+                ChunkMesh chunkMesh;
+                start = std::chrono::high_resolution_clock::now();
+                meshChunkData({x, z}, chunkData, chunkMesh);
+                meshElapsed += std::chrono::high_resolution_clock::now() - start;
+
+                // what the buffers take once uploaded
+                chunkMesh.isInitialized = true;
+                chunkMesh.transparentInitialized = true;
+
+                chunks++;
+                vertices += chunkMesh.vertices_opaque.size() + chunkMesh.vertices_transparent.size();
+                largestQuads = std::max(largestQuads, std::max(chunkMesh.vertices_opaque.size(), chunkMesh.vertices_transparent.size()) / 4);
+                opaqueVertices += chunkMesh.vertices_opaque.size();
+                bytes += chunkMeshGpuBytes(chunkMesh);
+                faceArea[pass] += opaqueFaceArea(chunkMesh);
+            }
+        }
+
+        std::cout << (pass == 0 ? "per face:" : "greedy:") << std::endl;
+        std::cout << "  mesh:     " << chunks << " chunks, " << meshElapsed.count() * 1000.0 / chunks << " ms per chunk" << std::endl;
+        std::cout << "  collect:  " << collectElapsed.count() * 1e6 / chunks << " us per chunk under data_mtx" << std::endl;
+        std::cout << "  vertices per chunk: " << vertices / chunks << " (" << opaqueVertices / chunks << " opaque)" << std::endl;
+        std::cout << "  vram per chunk: " << bytes / chunks / 1024.0 << " KiB, shared quad indices for the largest mesh: "
+                  << largestQuads * 6 * sizeof(unsigned int) / 1024.0 << " KiB" << std::endl;
+    }
+    greedy_meshing = true;
+
+    std::cout << "opaque faces covered: " << (size_t)faceArea[0] << " per face, " << (size_t)faceArea[1] << " greedy" << std::endl;
+}
+
+// The face culling the mesher did before cullSectionFaces, one voxel and
+// six neighbour lookups at a time, kept to check the masks against
+void referenceSectionFaces(ChunkData &chunkData, int section, SectionFaces &faces)
+{
+    const ChunkStorage &data = *chunkData.chunkData;
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int sectionY = 0; sectionY < SECTION_HEIGHT; sectionY++)
+        {
+            int y = section * SECTION_HEIGHT + sectionY;
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                char cover = 0;
+                bool liquidOnTop = false;
+                if (data.isOpaque(x, y, z))
+                {
+                    cover |= (z <= 0 ? !chunkData.northChunkData->isOpaque(x, y, CHUNK_SIZE - 1) : !data.isOpaque(x, y, z - 1)) ? 1 : 0;
+                    cover |= (z >= CHUNK_SIZE - 1 ? !chunkData.southChunkData->isOpaque(x, y, 0) : !data.isOpaque(x, y, z + 1)) ? 2 : 0;
+                    cover |= (x <= 0 ? !chunkData.westChunkData->isOpaque(CHUNK_SIZE - 1, y, z) : !data.isOpaque(x - 1, y, z)) ? 4 : 0;
+                    cover |= (x >= CHUNK_SIZE - 1 ? !chunkData.eastChunkData->isOpaque(0, y, z) : !data.isOpaque(x + 1, y, z)) ? 8 : 0;
+                    cover |= (y <= 0 || !data.isOpaque(x, y - 1, z)) ? 16 : 0;
+                    cover |= (y >= CHUNK_HEIGHT - 1 || !data.isOpaque(x, y + 1, z)) ? 32 : 0;
+                }
+                else if (data.isOccupied(x, y, z))
+                {
+                    BLOCK block = data.get(x, y, z);
+                    cover |= (z <= 0 ? !chunkData.northChunkData->isOccupied(x, y, CHUNK_SIZE - 1) : !data.isOccupied(x, y, z - 1)) ? 1 : 0;
+                    cover |= (z >= CHUNK_SIZE - 1 ? !chunkData.southChunkData->isOccupied(x, y, 0) : !data.isOccupied(x, y, z + 1)) ? 2 : 0;
+                    cover |= (x <= 0 ? !chunkData.westChunkData->isOccupied(CHUNK_SIZE - 1, y, z) : !data.isOccupied(x - 1, y, z)) ? 4 : 0;
+                    cover |= (x >= CHUNK_SIZE - 1 ? !chunkData.eastChunkData->isOccupied(0, y, z) : !data.isOccupied(x + 1, y, z)) ? 8 : 0;
+                    cover |= (y <= 0 || !data.isOccupied(x, y - 1, z)) ? 16 : 0;
+                    if (y >= CHUNK_HEIGHT - 1 || data.get(x, y + 1, z) != block)
+                        cover |= 32;
+                    else
+                        liquidOnTop = true;
+                }
+                faces.covers[x][sectionY][z] = cover;
+                faces.liquidOnTop[x][sectionY][z] = liquidOnTop;
+            }
+        }
+    }
+}
+
+// Culls every non empty section of the region's interior with both the
+// per voxel reference and the row masks, checks they agree and reports the
+// visible faces found per second on one core. Fails on any section where
+// they differ.
+bool benchFaces(World &world, int radius)
+{
+    generateRegion(world, radius);
+
+    std::vector<ChunkData> chunks;
+    for (int x = -radius + 1; x < radius; x++)
+    {
+        for (int z = -radius + 1; z < radius; z++)
+        {
+            ChunkData chunkData;
+            world.collectChunkData({x, z}, chunkData);
+            chunks.push_back(chunkData);
+        }
+    }
+
+    static SectionFaces reference;
+    static SectionFaces masked;
+    size_t sections = 0;
+    size_t faces = 0;
+    size_t mismatches = 0;
+    for (ChunkData &chunkData : chunks)
+    {
+        for (int section = 0; section < SECTIONS_PER_CHUNK; section++)
+        {
+            if (chunkData.chunkData->getSection(section).isEmpty())
+                continue;
+
+            referenceSectionFaces(chunkData, section, reference);
+            cullSectionFaces(chunkData, section, masked);
+            sections++;
+            mismatches += memcmp(reference.covers, masked.covers, sizeof(reference.covers)) != 0 ||
+                          memcmp(reference.liquidOnTop, masked.liquidOnTop, sizeof(reference.liquidOnTop)) != 0;
+            for (int i = 0; i < BLOCKS_PER_SECTION; i++)
+                faces += __builtin_popcount((unsigned char)(&masked.covers[0][0][0])[i]);
+        }
+    }
+    std::cout << sections << " sections, " << faces << " visible faces, " << mismatches << " sections differ" << std::endl;
+
+    auto timeCulling = [&](void (*cull)(ChunkData &, int, SectionFaces &), SectionFaces &out)
+    {
+        int rounds = 5;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < rounds; round++)
+        {
+            for (ChunkData &chunkData : chunks)
+            {
+                for (int section = 0; section < SECTIONS_PER_CHUNK; section++)
+                {
+                    if (!chunkData.chunkData->getSection(section).isEmpty())
+                        cull(chunkData, section, out);
+                }
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return faces * rounds / elapsed.count();
+    };
+    double referenceRate = timeCulling(referenceSectionFaces, reference);
+    double maskedRate = timeCulling(cullSectionFaces, masked);
+    std::cout << "per voxel: " << referenceRate / 1e6 << " M faces/s" << std::endl;
+    std::cout << "row masks: " << maskedRate / 1e6 << " M faces/s (" << maskedRate / referenceRate << "x)" << std::endl;
+    return mismatches == 0;
+}
+
+// Packs every field value of the vertex format on its own and every position
+// together, checks each unpacks to what went in, then compares a region's
+// meshes against the 20 byte float vertex they replaced. Fails on any value
+// that doesn't survive the round trip or mesh vertex outside its chunk.
+bool benchVertex(World &world, int radius)
+{
+    size_t checked = 0;
+    size_t mismatches = 0;
+    auto check = [&](int x, int y, int z, bool lowered, int tileCol, int tileRow, int repeatU, int repeatV)
+    {
+        UnpackedVertex vertex = unpackVertex(packVertex(x, y, z, lowered, tileCol, tileRow, repeatU, repeatV));
+        checked++;
+        if (vertex.x != x || vertex.y != y || vertex.z != z || vertex.lowered != lowered ||
+            vertex.tileCol != tileCol || vertex.tileRow != tileRow || vertex.repeatU != repeatU || vertex.repeatV != repeatV)
+            mismatches++;
+    };
+
+    for (int x = 0; x <= CHUNK_SIZE; x++)
+    {
+        for (int y = 0; y <= CHUNK_HEIGHT; y++)
+        {
+            for (int z = 0; z <= CHUNK_SIZE; z++)
+            {
+                check(x, y, z, false, 63, 63, 16, 16);
+                check(x, y, z, true, 0, 0, 0, 0);
+            }
+        }
+    }
+    for (int tile = 0; tile < 64; tile++)
+    {
+        for (int repeat = 0; repeat <= SECTION_HEIGHT; repeat++)
+        {
+            check(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE, true, tile, 63 - tile, repeat, SECTION_HEIGHT - repeat);
+        }
+    }
+    std::cout << "round trip: " << checked << " vertices, " << mismatches << " mismatches" << std::endl;
+
+    generateRegion(world, radius);
+    size_t chunks = 0;
+    size_t vertices = 0;
+    size_t outside = 0;
+    for (int x = -radius + 1; x < radius; x++)
+    {
+        for (int z = -radius + 1; z < radius; z++)
+        {
+            ChunkData chunkData;
+            world.collectChunkData({x, z}, chunkData);
+            ChunkMesh chunkMesh;
+            meshChunkData({x, z}, chunkData, chunkMesh);
+            chunks++;
+            vertices += chunkMesh.vertices_opaque.size() + chunkMesh.vertices_transparent.size();
+            for (auto *meshVertices : {&chunkMesh.vertices_opaque, &chunkMesh.vertices_transparent})
+            {
+                for (Vertex vertex : *meshVertices)
+                {
+                    UnpackedVertex unpacked = unpackVertex(vertex);
+                    if (unpacked.x > CHUNK_SIZE || unpacked.y > CHUNK_HEIGHT || unpacked.z > CHUNK_SIZE)
+                        outside++;
+                }
+            }
+        }
+    }
+    size_t floatVertexSize = sizeof(glm::vec3) + sizeof(glm::vec2);
+    std::cout << "vertices per chunk: " << vertices / chunks << ", " << vertices * floatVertexSize / chunks / 1024.0 << " KiB as float vertices, "
+              << vertices * sizeof(Vertex) / chunks / 1024.0 << " KiB packed" << std::endl;
+    std::cout << "vertices outside their chunk: " << outside << std::endl;
+    return mismatches == 0 && outside == 0;
+}
+
+// The hash ChunkDataMap used before the grid, kept to show what it cost
+struct XorChunkPosHash
+{
+    std::size_t operator()(const ChunkPos &v) const noexcept
+    {
+        return std::hash<int>()(v.x) ^ std::hash<int>()(v.z);
+    }
+};
+
+// Runs the mesher's access pattern (a chunk plus its four neighbours, for
+// every chunk in the window) over and over and returns ns per lookup.
+template <class Lookup>
+double timeLookups(int radius, int rounds, Lookup &&lookup)
+{
+    long long found = 0;
+    long long lookups = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int x = -radius + 1; x < radius; x++)
+        {
+            for (int z = -radius + 1; z < radius; z++)
+            {
+                found += lookup({x, z}) + lookup({x, z - 1}) + lookup({x, z + 1}) + lookup({x - 1, z}) + lookup({x + 1, z});
+                lookups += 5;
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    if (found != lookups)
+        std::cout << "lookup mismatch: " << found << " of " << lookups << std::endl;
+    return elapsed.count() * 1e9 / lookups;
+}
+
+template <class Map>
+size_t largestBucket(Map &map)
+{
+    size_t largest = 0;
+    for (size_t i = 0; i < map.bucket_count(); i++)
+    {
+        largest = std::max(largest, map.bucket_size(i));
+    }
+    return largest;
+}
+
+void benchGrid(int radius)
+{
+    int rounds = 2000;
+    std::unordered_map<ChunkPos, int, XorChunkPosHash, ChunkPosEqual> xorMap;
+    std::unordered_map<ChunkPos, int, ChunkPosHash, ChunkPosEqual> hashMap;
+    ChunkGrid<int> grid(radius);
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            xorMap[{x, z}] = 1;
+            hashMap[{x, z}] = 1;
+            grid.insert({x, z}, 1);
+        }
+    }
+
+    double xorNs = timeLookups(radius, rounds, [&](ChunkPos pos)
+                               { return xorMap.find(pos) != xorMap.end() ? xorMap.find(pos)->second : 0; });
+    double hashNs = timeLookups(radius, rounds, [&](ChunkPos pos)
+                                { return hashMap.find(pos) != hashMap.end() ? hashMap.find(pos)->second : 0; });
+    double gridNs = timeLookups(radius, rounds, [&](ChunkPos pos)
+                                { int *value = grid.find(pos); return value ? *value : 0; });
+
+    std::cout << "window: " << grid.getSize() << "x" << grid.getSize() << " chunks" << std::endl;
+    std::cout << "unordered_map, xor hash:    " << xorNs << " ns per lookup (largest bucket " << largestBucket(xorMap) << ")" << std::endl;
+    std::cout << "unordered_map, packed hash: " << hashNs << " ns per lookup (largest bucket " << largestBucket(hashMap) << ")" << std::endl;
+    std::cout << "toroidal grid:              " << gridNs << " ns per lookup" << std::endl;
+}
+
+bool sameBlocks(const ChunkStorage &a, const ChunkStorage &b)
+{
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int y = 0; y < CHUNK_HEIGHT; y++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                if (a.get(x, y, z) != b.get(x, y, z))
+                    return false;
+            }
+        }
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            if (a.getHeight(x, z) != b.getHeight(x, z) || a.getBiome(x, z) != b.getBiome(x, z))
+                return false;
+        }
+    }
+    return a.getStage() == b.getStage();
+}
+
+// Writes the region to a scratch region store, then reads every chunk back
+// and checks it against the generated copy
+void benchRegion(World &world, int radius)
+{
+    std::string directory = (std::filesystem::temp_directory_path() / "voxwrld_bench_regions").string();
+    std::filesystem::remove_all(directory);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    generateRegion(world, radius);
+    std::chrono::duration<double> generateElapsed = std::chrono::high_resolution_clock::now() - start;
+    int chunks = (2 * radius + 1) * (2 * radius + 1);
+
+    size_t mismatches = 0;
+    std::chrono::duration<double> writeElapsed(0);
+    std::chrono::duration<double> loadElapsed(0);
+    size_t bytesWritten = 0;
+    {
+        RegionStore store(directory);
+        start = std::chrono::high_resolution_clock::now();
+        for (int x = -radius; x <= radius; x++)
+        {
+            for (int z = -radius; z <= radius; z++)
+            {
+                store.save({x, z}, world.getChunkDataIfExists({x, z}));
+            }
+        }
+        store.flush();
+        writeElapsed = std::chrono::high_resolution_clock::now() - start;
+        bytesWritten = store.getBytesWritten();
+    }
+
+    // a fresh store so nothing is served from the write queue
+    RegionStore store(directory);
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            start = std::chrono::high_resolution_clock::now();
+            ChunkSnapshot loaded = store.load({x, z});
+            loadElapsed += std::chrono::high_resolution_clock::now() - start;
+
+            if (!loaded || !sameBlocks(*loaded, *world.getChunkDataIfExists({x, z})))
+                mismatches++;
+        }
+    }
+
+    // Saves every chunk a few more times with different edits, then checks
+    // what the region files take before and after the store compacts them on
+    // close
+    auto regionBytes = [&]
+    {
+        size_t bytes = 0;
+        for (const auto &file : std::filesystem::directory_iterator(directory))
+            bytes += file.file_size();
+        return bytes;
+    };
+    size_t firstBytes = regionBytes();
+    size_t rewrittenBytes = 0;
+    std::vector<ChunkSnapshot> lastEdits;
+    {
+        RegionStore rewrite(directory);
+        int editsPerRound[3] = {24, 8, 16};
+        for (int round = 0; round < 3; round++)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                for (int z = -radius; z <= radius; z++)
+                {
+                    std::shared_ptr<ChunkStorage> edited = std::make_shared<ChunkStorage>(*world.getChunkDataIfExists({x, z}));
+                    for (int i = 0; i < editsPerRound[round]; i++)
+                        edited->set(i % CHUNK_SIZE, CHUNK_HEIGHT - 1 - i / CHUNK_SIZE, (i * 7) % CHUNK_SIZE, BLOCK::STONE_BLOCK);
+                    rewrite.save({x, z}, edited);
+                    if (round == 2)
+                        lastEdits.push_back(edited);
+                }
+            }
+            rewrite.flush();
+        }
+        rewrittenBytes = regionBytes();
+    }
+    size_t compactedBytes = regionBytes();
+
+    size_t compactedMismatches = 0;
+    {
+        RegionStore compacted(directory);
+        size_t i = 0;
+        for (int x = -radius; x <= radius; x++)
+        {
+            for (int z = -radius; z <= radius; z++, i++)
+            {
+                ChunkSnapshot loaded = compacted.load({x, z});
+                if (!loaded || !sameBlocks(*loaded, *lastEdits[i]))
+                    compactedMismatches++;
+            }
+        }
+    }
+
+    std::cout << "generate: " << generateElapsed.count() * 1000.0 / chunks << " ms per chunk" << std::endl;
+    std::cout << "write:    " << writeElapsed.count() * 1000.0 / chunks << " ms per chunk, " << bytesWritten / chunks << " bytes per chunk" << std::endl;
+    std::cout << "load:     " << loadElapsed.count() * 1000.0 / chunks << " ms per chunk" << std::endl;
+    std::cout << "mismatched chunks: " << mismatches << " of " << chunks << std::endl;
+    std::cout << "region files: " << firstBytes << " bytes, " << rewrittenBytes << " after 3 rewrites, " << compactedBytes << " compacted" << std::endl;
+    std::cout << "mismatched chunks after compacting: " << compactedMismatches << " of " << chunks << std::endl;
+    std::filesystem::remove_all(directory);
+}
+
+// Compression ratio and throughput of the chunk codec. Throughput is given
+// in terms of the serialized sections the codec actually consumes.
+void benchCodec(World &world, int radius)
+{
+    generateRegion(world, radius);
+
+    std::vector<std::vector<uint8_t>> serialized;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            serialized.emplace_back();
+            world.getChunkDataIfExists({x, z})->serialize(serialized.back());
+        }
+    }
+
+    int rounds = 20;
+    size_t serializedBytes = 0;
+    size_t encodedBytes = 0;
+    std::vector<std::vector<uint8_t>> encoded(serialized.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < serialized.size(); i++)
+        {
+            encoded[i].clear();
+            lzCompress(serialized[i].data(), serialized[i].size(), encoded[i]);
+        }
+    }
+    std::chrono::duration<double> encodeElapsed = std::chrono::high_resolution_clock::now() - start;
+
+    std::vector<std::vector<uint8_t>> decoded(encoded.size());
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            lzDecompress(encoded[i].data(), encoded[i].size(), decoded[i]);
+        }
+    }
+    std::chrono::duration<double> decodeElapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < encoded.size(); i++)
+    {
+        if (decoded[i] != serialized[i])
+            mismatches++;
+    }
+
+    for (size_t i = 0; i < serialized.size(); i++)
+    {
+        serializedBytes += serialized[i].size();
+        encodedBytes += encoded[i].size();
+    }
+
+    size_t chunks = serialized.size();
+    double processed = (double)serializedBytes * rounds;
+    std::cout << "chunks: " << chunks << std::endl;
+    std::cout << "raw bytes per chunk:        " << (BLOCKS_PER_CHUNK) << std::endl;
+    std::cout << "serialized bytes per chunk: " << serializedBytes / chunks << std::endl;
+    std::cout << "encoded bytes per chunk:    " << encodedBytes / chunks << std::endl;
+    std::cout << "ratio vs raw: " << (double)chunks * (BLOCKS_PER_CHUNK) / encodedBytes << "x, vs serialized: " << (double)serializedBytes / encodedBytes << "x" << std::endl;
+    std::cout << "encode: " << processed / encodeElapsed.count() / 1e9 << " GB/s, " << encodeElapsed.count() * 1e6 / (chunks * rounds) << " us per chunk" << std::endl;
+    std::cout << "decode: " << processed / decodeElapsed.count() / 1e9 << " GB/s, " << decodeElapsed.count() * 1e6 / (chunks * rounds) << " us per chunk" << std::endl;
+    std::cout << "mismatches: " << mismatches << std::endl;
+}
+
+// The paths whose speed depends on the voxel order inside a section. Build
+// once per layout (-DVOXWRLD_VOXEL_LAYOUT=XYZ|COLUMN|MORTON) and compare.
+void benchLayout(World &world, int radius)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    generateRegion(world, radius);
+    std::chrono::duration<double> generateElapsed = std::chrono::high_resolution_clock::now() - start;
+    int generatedChunks = (2 * radius + 1) * (2 * radius + 1);
+
+    // Whole chunk reads in the generator's column order and the mesher's order
+    std::vector<ChunkSnapshot> snapshots;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            snapshots.push_back(world.getChunkDataIfExists({x, z}));
+        }
+    }
+    long long checksum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const ChunkSnapshot &data : snapshots)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                for (int y = 0; y < CHUNK_HEIGHT; y++)
+                {
+                    checksum += data->get(x, y, z);
+                }
+            }
+        }
+    }
+    std::chrono::duration<double> columnElapsed = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    for (const ChunkSnapshot &data : snapshots)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int y = 0; y < CHUNK_HEIGHT; y++)
+            {
+                for (int z = 0; z < CHUNK_SIZE; z++)
+                {
+                    checksum -= data->get(x, y, z);
+                }
+            }
+        }
+    }
+    std::chrono::duration<double> meshOrderElapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t meshedChunks = 0;
+    std::chrono::duration<double> meshElapsed(0);
+    for (int x = -radius + 1; x < radius; x++)
+    {
+        for (int z = -radius + 1; z < radius; z++)
+        {
+            ChunkData chunkData;
+            world.collectChunkData({x, z}, chunkData);
+            ChunkMesh chunkMesh;
+            start = std::chrono::high_resolution_clock::now();
+            meshChunkData({x, z}, chunkData, chunkMesh);
+            meshElapsed += std::chrono::high_resolution_clock::now() - start;
+            meshedChunks++;
+        }
+    }
+
+    // Slanted rays from above every chunk down into the terrain
+    const glm::vec3 directions[] = {{0.3f, -1.0f, 0.2f}, {-0.5f, -0.6f, 0.1f}, {0.1f, -0.4f, -0.7f}, {-0.2f, -0.9f, -0.4f}};
+    size_t rays = 0;
+    size_t hits = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (int x = -radius + 2; x < radius - 1; x++)
+    {
+        for (int z = -radius + 2; z < radius - 1; z++)
+        {
+            for (const glm::vec3 &direction : directions)
+            {
+                RayCastInfo info = {world, glm::vec3(x * CHUNK_SIZE + 8.5f, 140.5f, z * CHUNK_SIZE + 8.5f), glm::normalize(direction), 160.0f, doNothingIfHit};
+                hits += shoot_ray(info);
+                rays++;
+            }
+        }
+    }
+    std::chrono::duration<double> rayElapsed = std::chrono::high_resolution_clock::now() - start;
+
+    double voxels = (double)snapshots.size() * (BLOCKS_PER_CHUNK);
+    std::cout << "layout:   " << VOXEL_LAYOUT_NAME << std::endl;
+    std::cout << "generate: " << generateElapsed.count() * 1000.0 / generatedChunks << " ms per chunk" << std::endl;
+    std::cout << "read in column order: " << columnElapsed.count() * 1e9 / voxels << " ns per voxel" << std::endl;
+    std::cout << "read in mesh order:   " << meshOrderElapsed.count() * 1e9 / voxels << " ns per voxel" << std::endl;
+    std::cout << "mesh:     " << meshElapsed.count() * 1000.0 / meshedChunks << " ms per chunk" << std::endl;
+    std::cout << "raycast:  " << rays / rayElapsed.count() << " rays per second (" << hits << " of " << rays << " hit)" << std::endl;
+    if (checksum != 0)
+        std::cout << "read mismatch" << std::endl;
+}
+
+// Times the scalar library against the batched noise on the coordinates the
+// generator uses and checks every result for bit equality. Fails on any
+// result that differs.
+bool benchNoise(World &world, int radius)
+{
+    BatchPerlin batchPerlin(perlin);
+
+    std::vector<double> x2, z2, x3, y3, z3;
+    for (int cx = -radius; cx <= radius; cx++)
+    {
+        for (int cz = -radius; cz <= radius; cz++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                for (int z = 0; z < CHUNK_SIZE; z++)
+                {
+                    x2.push_back(0.007 * (cx * CHUNK_SIZE + x));
+                    z2.push_back(0.007 * (cz * CHUNK_SIZE + z));
+                    for (int y = 0; y <= 80; y += 8)
+                    {
+                        x3.push_back(0.05 * (cx * CHUNK_SIZE + x));
+                        y3.push_back(0.05 * y);
+                        z3.push_back(0.05 * (cz * CHUNK_SIZE + z));
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<double> scalar2(x2.size()), batch2(x2.size()), scalar3(x3.size()), batch3(x3.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < x2.size(); i++)
+    {
+        scalar2[i] = perlin.octave2D_01(x2[i], z2[i], 12);
+    }
+    std::chrono::duration<double> scalar2Elapsed = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    batchPerlin.octave2D_01(x2.data(), z2.data(), batch2.data(), x2.size(), 12);
+    std::chrono::duration<double> batch2Elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < x3.size(); i++)
+    {
+        scalar3[i] = perlin.octave3D_01(x3[i], y3[i], z3[i], 12);
+    }
+    std::chrono::duration<double> scalar3Elapsed = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    batchPerlin.octave3D_01(x3.data(), y3.data(), z3.data(), batch3.data(), x3.size(), 12);
+    std::chrono::duration<double> batch3Elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < x2.size(); i++)
+    {
+        mismatches += memcmp(&scalar2[i], &batch2[i], sizeof(double)) != 0;
+    }
+    for (size_t i = 0; i < x3.size(); i++)
+    {
+        mismatches += memcmp(&scalar3[i], &batch3[i], sizeof(double)) != 0;
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    generateRegion(world, radius);
+    std::chrono::duration<double> generateElapsed = std::chrono::high_resolution_clock::now() - start;
+    int chunks = (2 * radius + 1) * (2 * radius + 1);
+
+    std::cout << "path: " << batchPerlin.getPath() << std::endl;
+    std::cout << "2D, 12 octaves: scalar " << scalar2Elapsed.count() * 1e9 / x2.size() << " ns, batched " << batch2Elapsed.count() * 1e9 / x2.size() << " ns per point" << std::endl;
+    std::cout << "3D, 12 octaves: scalar " << scalar3Elapsed.count() * 1e9 / x3.size() << " ns, batched " << batch3Elapsed.count() * 1e9 / x3.size() << " ns per point" << std::endl;
+    std::cout << "mismatches: " << mismatches << " of " << x2.size() + x3.size() << std::endl;
+    std::cout << "generate: " << chunks / generateElapsed.count() << " chunks per second" << std::endl;
+    return mismatches == 0;
+}
+
+// Generates the area with the exact cave noise and again with the lattice
+// and compares the carved voxels, air with something solid above it in the
+// column. caves_diff.ppm is a top down view with a pixel per column: green
+// where both carved, red where only the exact pass and blue where only the
+// lattice carved.
+void benchCaves(World &world, int radius)
+{
+    std::vector<ChunkSnapshot> passes[2];
+    std::chrono::duration<double> elapsed[2];
+    for (int pass = 0; pass < 2; pass++)
+    {
+        exact_caves = pass == 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        generateRegion(world, radius);
+        elapsed[pass] = std::chrono::high_resolution_clock::now() - start;
+        for (int x = -radius; x <= radius; x++)
+        {
+            for (int z = -radius; z <= radius; z++)
+            {
+                passes[pass].push_back(world.getChunkDataIfExists({x, z}));
+            }
+        }
+    }
+    exact_caves = false;
+
+    int width = (2 * radius + 1) * CHUNK_SIZE;
+    std::vector<uint8_t> image(width * width * 3, 0);
+    size_t carved[2] = {0, 0};
+    size_t mismatches = 0;
+    for (size_t chunk = 0; chunk < passes[0].size(); chunk++)
+    {
+        int chunkX = chunk / (2 * radius + 1);
+        int chunkZ = chunk % (2 * radius + 1);
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                int onlyExact = 0, onlyLattice = 0, both = 0;
+                bool covered[2] = {false, false};
+                for (int y = CHUNK_HEIGHT - 1; y >= 0; y--)
+                {
+                    bool isCarved[2];
+                    for (int pass = 0; pass < 2; pass++)
+                    {
+                        BLOCK block = passes[pass][chunk]->get(x, y, z);
+                        isCarved[pass] = covered[pass] && block == BLOCK::AIR_BLOCK;
+                        covered[pass] |= block != BLOCK::AIR_BLOCK;
+                        carved[pass] += isCarved[pass];
+                    }
+                    onlyExact += isCarved[0] && !isCarved[1];
+                    onlyLattice += !isCarved[0] && isCarved[1];
+                    both += isCarved[0] && isCarved[1];
+                }
+                mismatches += onlyExact + onlyLattice;
+
+                uint8_t *pixel = &image[((chunkZ * CHUNK_SIZE + z) * width + chunkX * CHUNK_SIZE + x) * 3];
+                pixel[0] = std::min(255, onlyExact * 32);
+                pixel[1] = std::min(255, both * 8);
+                pixel[2] = std::min(255, onlyLattice * 32);
+            }
+        }
+    }
+
+    std::ofstream ppm("caves_diff.ppm", std::ios::binary);
+    ppm << "P6\n"
+        << width << " " << width << "\n255\n";
+    ppm.write((const char *)image.data(), image.size());
+
+    int chunks = passes[0].size();
+    std::cout << "exact:   " << elapsed[0].count() * 1000.0 / chunks << " ms per chunk, " << carved[0] / chunks << " carved voxels per chunk" << std::endl;
+    std::cout << "lattice: " << elapsed[1].count() * 1000.0 / chunks << " ms per chunk, " << carved[1] / chunks << " carved voxels per chunk" << std::endl;
+    std::cout << "mismatched voxels: " << mismatches / chunks << " per chunk (" << 100.0 * mismatches / std::max<size_t>(carved[0], 1) << "% of the exact caves)" << std::endl;
+    std::cout << "diff image: caves_diff.ppm" << std::endl;
+}
+
+// Generates the region once on a single thread in order and once on several
+// threads in a shuffled order, each into a fresh world, and compares the
+// serialized chunks. Trees that cross chunk borders are part of the bytes, so
+// this also covers the hand over between neighbours. Fails on any chunk
+// that differs.
+bool benchDeterminism(int radius)
+{
+    std::vector<ChunkPos> order;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            order.push_back({x, z});
+        }
+    }
+
+    int threads = std::max(4u, std::thread::hardware_concurrency());
+    std::vector<std::vector<uint8_t>> runs[2];
+    std::chrono::duration<double> elapsed[2];
+    for (int run = 0; run < 2; run++)
+    {
+        World world;
+        std::vector<ChunkPos> runOrder = order;
+        if (run == 1)
+            std::shuffle(runOrder.begin(), runOrder.end(), std::mt19937(1));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            // The pool finishes every queued chunk before it is destroyed
+            ThreadPool pool(run == 0 ? 1 : threads);
+            for (ChunkPos pos : runOrder)
+            {
+                pool.enqueue([&world, pos]
+                             { world.generateChunkData(pos); });
+            }
+        }
+        elapsed[run] = std::chrono::high_resolution_clock::now() - start;
+
+        for (ChunkPos pos : order)
+        {
+            runs[run].emplace_back();
+            world.getChunkDataIfExists(pos)->serialize(runs[run].back());
+        }
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        mismatches += runs[0][i] != runs[1][i];
+    }
+
+    std::cout << "1 thread:  " << order.size() / elapsed[0].count() << " chunks/s" << std::endl;
+    std::cout << threads << " threads: " << order.size() / elapsed[1].count() << " chunks/s, shuffled order" << std::endl;
+    std::cout << "mismatched chunks: " << mismatches << " of " << order.size() << std::endl;
+    return mismatches == 0;
+}
+
+// Generates the region one chunk at a time, each chunk split over the
+// world's generation workers, then with every chunk submitted at once. Both
+// runs start from a fresh world.
+void benchGeneration(int radius)
+{
+    std::vector<ChunkPos> order;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            order.push_back({x, z});
+        }
+    }
+
+    size_t threads = 0;
+    std::chrono::duration<double> elapsed[2];
+    for (int run = 0; run < 2; run++)
+    {
+        World world;
+        threads = world.getGenerationThreadCount();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (run == 0)
+        {
+            for (ChunkPos pos : order)
+            {
+                world.generateChunkData(pos);
+            }
+        }
+        else
+        {
+            // The scheduler finishes every submitted chunk before it is destroyed
+            TaskScheduler scheduler(threads);
+            for (ChunkPos pos : order)
+            {
+                scheduler.submit([&world, pos]
+                                 { world.generateChunkData(pos); });
+            }
+        }
+        elapsed[run] = std::chrono::high_resolution_clock::now() - start;
+    }
+
+    std::cout << threads << " generation threads" << std::endl;
+    std::cout << "one at a time: " << elapsed[0].count() * 1000.0 / order.size() << " ms per chunk" << std::endl;
+    std::cout << "all at once:   " << order.size() / elapsed[1].count() << " chunks/s" << std::endl;
+}
+
+// Appends to the chunks of the region from several threads at once, takes
+// everything back and checks that no block was lost, once after the appends
+// and once while they run. Then refills it with one block per chunk and lets
+// cleanup enforce a tiny bound. Fails when a block goes missing.
+bool benchSpill(int radius)
+{
+    int threads = std::max(4u, std::thread::hardware_concurrency());
+    int batches = 50000;
+    int side = 2 * radius + 1;
+    int chunks = side * side;
+
+    SpillStore store(DEFAULT_SPILL_MAX_BLOCKS);
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        ThreadPool pool(threads);
+        for (int t = 0; t < threads; t++)
+        {
+            pool.enqueue([&store, t, batches, side, chunks, radius]
+                         {
+                BlockWithPos blocks[4] = {{0, 0, 0, BLOCK::OAK_LEAVES}, {1, 0, 0, BLOCK::OAK_LEAVES}, {2, 0, 0, BLOCK::OAK_LEAVES}, {3, 0, 0, BLOCK::OAK_WOOD}};
+                for (int i = 0; i < batches; i++)
+                {
+                    int chunk = (i + t) % chunks;
+                    store.append({chunk % side - radius, chunk / side - radius}, blocks, 4);
+                } });
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    size_t appended = (size_t)threads * batches * 4;
+    size_t taken = 0;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            taken += store.take({x, z}).size();
+        }
+    }
+    std::cout << threads << " threads: " << appended / elapsed.count() / 1e6 << " M blocks/s appended" << std::endl;
+    std::cout << "taken back: " << taken << " of " << appended << ", " << store.getStats().blocks << " left" << std::endl;
+
+    // Appends racing a thread that keeps taking the same chunks, every block
+    // has to come back exactly once
+    SpillStore raced(DEFAULT_SPILL_MAX_BLOCKS);
+    std::atomic<bool> appending{true};
+    size_t racedTaken = 0;
+    std::thread taker([&]
+                      {
+        while (appending)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                for (int z = -radius; z <= radius; z++)
+                    racedTaken += raced.take({x, z}).size();
+            }
+        } });
+    {
+        ThreadPool pool(threads);
+        for (int t = 0; t < threads; t++)
+        {
+            pool.enqueue([&raced, t, batches, side, chunks, radius]
+                         {
+                BlockWithPos block = {0, 0, 0, BLOCK::OAK_LEAVES};
+                for (int i = 0; i < batches; i++)
+                {
+                    int chunk = (i + t) % chunks;
+                    raced.append({chunk % side - radius, chunk / side - radius}, &block, 1);
+                } });
+        }
+    }
+    appending = false;
+    taker.join();
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+            racedTaken += raced.take({x, z}).size();
+    }
+    size_t racedAppended = (size_t)threads * batches;
+    std::cout << "taken while appending: " << racedTaken << " of " << racedAppended << ", " << raced.getStats().dropped << " dropped" << std::endl;
+
+    size_t bound = 9;
+    SpillStore bounded(bound);
+    BlockWithPos block = {0, 0, 0, BLOCK::OAK_LEAVES};
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            bounded.append({x, z}, &block, 1);
+        }
+    }
+    bounded.cleanup({0, 0}, 1, std::chrono::seconds(SPILL_TTL_SECONDS));
+    SpillStats stats = bounded.getStats();
+    std::cout << "after cleanup: " << stats.blocks << " blocks in " << stats.chunks << " chunks (bound " << bound << "), " << stats.dropped << " dropped" << std::endl;
+    return taken == appended && racedTaken == racedAppended;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: voxwrld_bench <storage|mesh|faces|vertex|grid|region|codec|layout|noise|caves|determinism|generation|spill> [radius]" << std::endl;
+        return 1;
+    }
+
+    log_chunk_generation = false;
+
+    std::string name = argv[1];
+    int radius = argc > 2 ? std::atoi(argv[2]) : 8;
+
+    // The benchmarks that check their results against a reference fail the
+    // run when they don't match
+    bool passed = true;
+    World world;
+    if (name == "storage")
+    {
+        benchStorage(world, radius);
+    }
+    else if (name == "mesh")
+    {
+        benchMesh(world, radius);
+    }
+    else if (name == "faces")
+    {
+        passed = benchFaces(world, radius);
+    }
+    else if (name == "vertex")
+    {
+        passed = benchVertex(world, radius);
+    }
+    else if (name == "grid")
+    {
+        benchGrid(radius);
+    }
+    else if (name == "region")
+    {
+        benchRegion(world, radius);
+    }
+    else if (name == "codec")
+    {
+        benchCodec(world, radius);
+    }
+    else if (name == "layout")
+    {
+        benchLayout(world, radius);
+    }
+    else if (name == "noise")
+    {
+        passed = benchNoise(world, radius);
+    }
+    else if (name == "caves")
+    {
+        benchCaves(world, radius);
+    }
+    else if (name == "determinism")
+    {
+        passed = benchDeterminism(radius);
+    }
+    else if (name == "generation")
+    {
+        benchGeneration(radius);
+    }
+    else if (name == "spill")
+    {
+        passed = benchSpill(radius);
+    }
+    else
+    {
+        std::cout << "unknown benchmark: " << name << std::endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "world/world.h"
+#include "world/chunkMesh.h"
+
+// Builds the square of chunks around the spawn into the region store in
+// ./world, where the game loads it from at startup. Run it from the
+// directory the game is started in.
+//
+// The square is generated one row along z at a time, each row spread over
+// the generation workers. A chunk is final once the rows on both sides of it
+// are decorated, so two rows behind the newest one every chunk is written
+// out and dropped from memory. One ring past the radius is generated so the
+// chunks on the edge get decorated, that ring itself is not written.
+// Chunks already in the region store are loaded instead of generated, so an
+// interrupted run picks up where it stopped.
+
+void printUsage()
+{
+    std::cout << "usage: voxwrld_pregen --radius <chunks> [--threads <count>]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int radius = -1;
+    int threads = std::thread::hardware_concurrency();
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--radius") == 0)
+        {
+            radius = std::atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            threads = std::atoi(argv[i + 1]);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (radius < 0 || argc % 2 == 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // The chunk grids are sized from the render distance, this makes them
+    // hold a whole row of the square without two chunks sharing a cell
+    int edge = radius + 1;
+    render_distance = edge;
+    log_chunk_generation = false;
+    World world(threads);
+
+    int side = 2 * edge + 1;
+    size_t total = (size_t)(2 * radius + 1) * (2 * radius + 1);
+    size_t written = 0;
+    std::cout << "generating " << total << " chunks on " << world.getGenerationThreadCount() << " threads" << std::endl;
+
+    auto unloadRow = [&](int x)
+    {
+        for (int z = -edge; z <= edge; z++)
+        {
+            bool inside = x >= -radius && x <= radius && z >= -radius && z <= radius;
+            world.unloadChunkData({x, z}, inside);
+            written += inside;
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int x = -edge; x <= edge; x++)
+    {
+        std::vector<ChunkPos> row;
+        for (int z = -edge; z <= edge; z++)
+        {
+            row.push_back({x, z});
+        }
+
+        world.generateChunks(row);
+
+        if (x - 2 >= -edge)
+            unloadRow(x - 2);
+
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "row " << x + edge + 1 << " of " << side << ": " << written << " of " << total << " chunks written, "
+                  << (x + edge + 1) * side / elapsed.count() << " chunks/s, "
+                  << world.getRegionBytesWritten() / (1024.0 * 1024.0) << " MiB" << std::endl;
+    }
+    unloadRow(edge - 1);
+    unloadRow(edge);
+    world.flushRegionStore();
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    size_t bytes = world.getRegionBytesWritten();
+    std::cout << "done: " << written << " chunks in " << elapsed.count() << " s, " << written / elapsed.count() << " chunks/s, "
+              << bytes << " bytes written (" << (written ? bytes / written : 0) << " per chunk)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include <cstring>
+
+#include "world/batchNoise.h"
+
+// The lanes are written with the GCC/Clang vector extensions, which compile
+// to SSE2 on any x86-64 and to AVX2 inside the target("avx2") wrapper below.
+// Other compilers fall back to the scalar library.
+#if defined(__GNUC__)
+#define BATCH_NOISE_VECTOR
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_NOISE_X86
+#endif
+#endif
+
+#ifdef BATCH_NOISE_VECTOR
+
+// The 4 lane helpers pass AVX sized vectors around but only ever end up
+// inlined into the AVX2 function, so the ABI note does not apply
+#if !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// Per gradient hash (h & 15) selection masks, see perlin_detail::Grad:
+// u = h < 8 ? x : y, v = h < 4 ? y : h == 12 || h == 14 ? x : z
+#define GRAD_SIGN (int64_t)0x8000000000000000ull
+static const int64_t gradUIsY[16] = {0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1, -1, -1, -1, -1};
+static const int64_t gradVIsY[16] = {-1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+static const int64_t gradVIsX[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 0, -1, 0};
+static const int64_t gradUSign[16] = {0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN, 0, GRAD_SIGN};
+static const int64_t gradVSign[16] = {0, 0, GRAD_SIGN, GRAD_SIGN, 0, 0, GRAD_SIGN, GRAD_SIGN, 0, 0, GRAD_SIGN, GRAD_SIGN, 0, 0, GRAD_SIGN, GRAD_SIGN};
+
+// vector_size can't depend on a template argument, so every width is spelled out
+template <int N>
+struct LaneTypes;
+
+template <>
+struct LaneTypes<2>
+{
+    typedef double Double __attribute__((vector_size(16)));
+    typedef int64_t Mask __attribute__((vector_size(16)));
+    typedef int32_t Int __attribute__((vector_size(8)));
+};
+
+template <>
+struct LaneTypes<4>
+{
+    typedef double Double __attribute__((vector_size(32)));
+    typedef int64_t Mask __attribute__((vector_size(32)));
+    typedef int32_t Int __attribute__((vector_size(16)));
+};
+
+template <int N>
+struct Lanes
+{
+    typedef typename LaneTypes<N>::Double Double;
+    typedef typename LaneTypes<N>::Mask Mask;
+    typedef typename LaneTypes<N>::Int Int;
+
+    // m ? b : a, lane by lane
+    static inline Double select(Mask m, Double a, Double b)
+    {
+        return (Double)(((Mask)a & ~m) | ((Mask)b & m));
+    }
+
+    // std::floor for the coordinate range the terrain uses (fits in int32)
+    static inline Double floor(Double x)
+    {
+        Double t = __builtin_convertvector(__builtin_convertvector(x, Int), Double);
+        Double one = t - t + 1.0;
+        return t - (Double)((Mask)(t > x) & (Mask)one);
+    }
+
+    static inline Double fade(Double t)
+    {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    }
+
+    static inline Double lerp(Double a, Double b, Double t)
+    {
+        return (a + (b - a) * t);
+    }
+
+    static inline Double grad(const int32_t *hash, Double x, Double y, Double z)
+    {
+        Mask uIsY, vIsY, vIsX, uSign, vSign;
+        for (int i = 0; i < N; i++)
+        {
+            int h = hash[i] & 15;
+            uIsY[i] = gradUIsY[h];
+            vIsY[i] = gradVIsY[h];
+            vIsX[i] = gradVIsX[h];
+            uSign[i] = gradUSign[h];
+            vSign[i] = gradVSign[h];
+        }
+        Double u = select(uIsY, x, y);
+        Double v = select(vIsX, select(vIsY, z, y), x);
+        return (Double)((Mask)u ^ uSign) + (Double)((Mask)v ^ vSign);
+    }
+
+    // BasicPerlinNoise::noise3D with the permutation lookups done per lane
+    static inline Double noise3D(const uint8_t *p, Double x, Double y, Double z)
+    {
+        Double _x = floor(x);
+        Double _y = floor(y);
+        Double _z = floor(z);
+
+        Int ix = __builtin_convertvector(_x, Int) & 255;
+        Int iy = __builtin_convertvector(_y, Int) & 255;
+        Int iz = __builtin_convertvector(_z, Int) & 255;
+
+        Double fx = x - _x;
+        Double fy = y - _y;
+        Double fz = z - _z;
+
+        Double u = fade(fx);
+        Double v = fade(fy);
+        Double w = fade(fz);
+
+        int32_t hash[8][N];
+        for (int i = 0; i < N; i++)
+        {
+            uint8_t A = (p[ix[i] & 255] + iy[i]) & 255;
+            uint8_t B = (p[(ix[i] + 1) & 255] + iy[i]) & 255;
+
+            uint8_t AA = (p[A] + iz[i]) & 255;
+            uint8_t AB = (p[(A + 1) & 255] + iz[i]) & 255;
+
+            uint8_t BA = (p[B] + iz[i]) & 255;
+            uint8_t BB = (p[(B + 1) & 255] + iz[i]) & 255;
+
+            hash[0][i] = p[AA];
+            hash[1][i] = p[BA];
+            hash[2][i] = p[AB];
+            hash[3][i] = p[BB];
+            hash[4][i] = p[(AA + 1) & 255];
+            hash[5][i] = p[(BA + 1) & 255];
+            hash[6][i] = p[(AB + 1) & 255];
+            hash[7][i] = p[(BB + 1) & 255];
+        }
+
+        Double p0 = grad(hash[0], fx, fy, fz);
+        Double p1 = grad(hash[1], fx - 1, fy, fz);
+        Double p2 = grad(hash[2], fx, fy - 1, fz);
+        Double p3 = grad(hash[3], fx - 1, fy - 1, fz);
+        Double p4 = grad(hash[4], fx, fy, fz - 1);
+        Double p5 = grad(hash[5], fx - 1, fy, fz - 1);
+        Double p6 = grad(hash[6], fx, fy - 1, fz - 1);
+        Double p7 = grad(hash[7], fx - 1, fy - 1, fz - 1);
+
+        Double q0 = lerp(p0, p1, u);
+        Double q1 = lerp(p2, p3, u);
+        Double q2 = lerp(p4, p5, u);
+        Double q3 = lerp(p6, p7, u);
+
+        Double r0 = lerp(q0, q1, v);
+        Double r1 = lerp(q2, q3, v);
+
+        return lerp(r0, r1, w);
+    }
+
+    // perlin_detail::Octave3D followed by RemapClamp_01 for N points. The 2D
+    // octaves are 3D noise at a fixed z that is not scaled per octave.
+    static inline void octave(const uint8_t *p, const double *x, const double *y, const double *z, bool zIsConstant, double *out, int octaves, double persistence)
+    {
+        Double px, py, pz;
+        memcpy(&px, x, sizeof(Double));
+        memcpy(&py, y, sizeof(Double));
+        if (zIsConstant)
+            pz = px - px + z[0];
+        else
+            memcpy(&pz, z, sizeof(Double));
+
+        Double result = px - px;
+        double amplitude = 1;
+        for (int i = 0; i < octaves; i++)
+        {
+            result += (noise3D(p, px, py, pz) * amplitude);
+            px *= 2;
+            py *= 2;
+            if (!zIsConstant)
+                pz *= 2;
+            amplitude *= persistence;
+        }
+
+        for (int i = 0; i < N; i++)
+        {
+            out[i] = result[i] <= -1.0 ? 0.0 : 1.0 <= result[i] ? 1.0 : (result[i] * 0.5 + 0.5);
+        }
+    }
+};
+
+static int octaveLanes2(const uint8_t *p, const double *x, const double *y, const double *z, bool zIsConstant, double *out, int count, int octaves, double persistence)
+{
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Lanes<2>::octave(p, x + i, y + i, zIsConstant ? z : z + i, zIsConstant, out + i, octaves, persistence);
+    }
+    return i;
+}
+
+#ifdef BATCH_NOISE_X86
+// Only AVX2 is enabled here, not FMA, so no multiply and add gets fused and
+// the rounding stays that of the scalar code
+__attribute__((target("avx2"), flatten)) static int octaveLanes4(const uint8_t *p, const double *x, const double *y, const double *z, bool zIsConstant, double *out, int count, int octaves, double persistence)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        Lanes<4>::octave(p, x + i, y + i, zIsConstant ? z : z + i, zIsConstant, out + i, octaves, persistence);
+    }
+    return i;
+}
+#endif
+
+#endif
+
+BatchPerlin::BatchPerlin(const siv::PerlinNoise &perlin) : perlin(perlin), useAvx2(false)
+{
+    memcpy(permutation, perlin.serialize().data(), sizeof(permutation));
+#ifdef BATCH_NOISE_X86
+    useAvx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+void BatchPerlin::octave2D_01(const double *x, const double *y, double *out, int count, int octaves, double persistence) const
+{
+    double z = SIVPERLIN_DEFAULT_Z;
+    octave3D(x, y, &z, true, out, count, octaves, persistence);
+}
+
+void BatchPerlin::octave3D_01(const double *x, const double *y, const double *z, double *out, int count, int octaves, double persistence) const
+{
+    octave3D(x, y, z, false, out, count, octaves, persistence);
+}
+
+const char *BatchPerlin::getPath() const
+{
+#ifdef BATCH_NOISE_VECTOR
+#ifdef BATCH_NOISE_X86
+    return useAvx2 ? "avx2" : "sse2";
+#else
+    return "vector";
+#endif
+#else
+    return "scalar";
+#endif
+}
+
+void BatchPerlin::octave3D(const double *x, const double *y, const double *z, bool zIsConstant, double *out, int count, int octaves, double persistence) const
+{
+    int done = 0;
+#ifdef BATCH_NOISE_VECTOR
+#ifdef BATCH_NOISE_X86
+    if (useAvx2)
+        done = octaveLanes4(permutation, x, y, z, zIsConstant, out, count, octaves, persistence);
+#endif
+    done += octaveLanes2(permutation, x + done, y + done, zIsConstant ? z : z + done, zIsConstant, out + done, count - done, octaves, persistence);
+#endif
+
+    // Whatever does not fill a whole batch goes through the library
+    for (int i = done; i < count; i++)
+    {
+        if (zIsConstant)
+            out[i] = perlin.octave2D_01(x[i], y[i], octaves, persistence);
+        else
+            out[i] = perlin.octave3D_01(x[i], y[i], z[i], octaves, persistence);
+    }
+}
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstring>
+
+#include "world/chunkCodec.h"
+#include "world/chunkStorage.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 13
+#define LZ_COPY_SLACK 16
+
+inline void writeVarint(std::vector<uint8_t> &out, size_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+inline bool readVarint(const uint8_t *&in, const uint8_t *end, size_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7)
+    {
+        uint8_t byte = *in++;
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline uint32_t hash4(const uint8_t *in)
+{
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+inline size_t matchLength(const uint8_t *a, const uint8_t *b, size_t limit)
+{
+    size_t length = 0;
+    while (length + 8 <= limit)
+    {
+        uint64_t wordA, wordB;
+        memcpy(&wordA, a + length, 8);
+        memcpy(&wordB, b + length, 8);
+        if (wordA != wordB)
+            break;
+        length += 8;
+    }
+    while (length < limit && a[length] == b[length])
+    {
+        length++;
+    }
+    return length;
+}
+
+// Greedy parse. Each position is checked against the last match offset
+// first, which catches the fixed row and layer strides of the packed
+// sections, then against the most recent position with the same 4 bytes.
+void lzCompress(const uint8_t *in, size_t size, std::vector<uint8_t> &out)
+{
+    writeVarint(out, size);
+
+    std::vector<uint32_t> table(1 << LZ_HASH_BITS, UINT32_MAX);
+    size_t pos = 0;
+    size_t literalStart = 0;
+    size_t lastOffset = 0;
+    while (pos + LZ_MIN_MATCH <= size)
+    {
+        size_t offset = 0;
+        size_t length = 0;
+        if (lastOffset > 0 && lastOffset <= pos)
+        {
+            length = matchLength(in + pos, in + pos - lastOffset, size - pos);
+            offset = lastOffset;
+        }
+
+        uint32_t hash = hash4(in + pos);
+        uint32_t candidate = table[hash];
+        table[hash] = pos;
+        if (candidate != UINT32_MAX && pos - candidate != offset)
+        {
+            size_t candidateLength = matchLength(in + pos, in + candidate, size - pos);
+            if (candidateLength > length)
+            {
+                length = candidateLength;
+                offset = pos - candidate;
+            }
+        }
+
+        if (length < LZ_MIN_MATCH)
+        {
+            pos++;
+            continue;
+        }
+
+        writeVarint(out, pos - literalStart);
+        out.insert(out.end(), in + literalStart, in + pos);
+        writeVarint(out, length - LZ_MIN_MATCH);
+        writeVarint(out, offset);
+
+        size_t matchEnd = pos + length;
+        for (pos++; pos < matchEnd && pos + LZ_MIN_MATCH <= size; pos++)
+        {
+            table[hash4(in + pos)] = pos;
+        }
+        pos = matchEnd;
+        literalStart = pos;
+        lastOffset = offset;
+    }
+
+    if (literalStart < size)
+    {
+        writeVarint(out, size - literalStart);
+        out.insert(out.end(), in + literalStart, in + size);
+    }
+}
+
+bool lzDecompress(const uint8_t *in, size_t size, std::vector<uint8_t> &out)
+{
+    const uint8_t *end = in + size;
+    size_t decodedSize;
+    if (!readVarint(in, end, decodedSize))
+        return false;
+
+    // Short copies are done as one fixed 16 byte copy, the slack at the end
+    // of the buffer absorbs the overrun and is trimmed again at the end
+    out.resize(decodedSize + LZ_COPY_SLACK);
+    uint8_t *dst = out.data();
+    size_t pos = 0;
+    while (pos < decodedSize)
+    {
+        size_t literals;
+        if (!readVarint(in, end, literals) || literals > (size_t)(end - in) || literals > decodedSize - pos)
+            return false;
+        if (literals <= LZ_COPY_SLACK && (size_t)(end - in) >= LZ_COPY_SLACK)
+            memcpy(dst + pos, in, LZ_COPY_SLACK);
+        else
+            memcpy(dst + pos, in, literals);
+        in += literals;
+        pos += literals;
+        if (pos == decodedSize)
+            break;
+
+        size_t length, offset;
+        if (!readVarint(in, end, length) || !readVarint(in, end, offset))
+            return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > pos || length > decodedSize - pos)
+            return false;
+
+        // An overlapping match repeats the last `offset` bytes. Every copy
+        // doubles the repeated span, so a long run is a handful of memcpys.
+        const uint8_t *src = dst + pos - offset;
+        if (offset >= LZ_COPY_SLACK && length <= LZ_COPY_SLACK)
+        {
+            memcpy(dst + pos, src, LZ_COPY_SLACK);
+            pos += length;
+            continue;
+        }
+
+        size_t copied = 0;
+        while (copied < length)
+        {
+            size_t count = std::min(copied + offset, length - copied);
+            memcpy(dst + pos + copied, src, count);
+            copied += count;
+        }
+        pos += length;
+    }
+    out.resize(decodedSize);
+    return in == end;
+}
+
+void encodeChunk(const ChunkStorage &data, std::vector<uint8_t> &out)
+{
+    std::vector<uint8_t> serialized;
+    data.serialize(serialized);
+    lzCompress(serialized.data(), serialized.size(), out);
+}
+
+bool decodeChunk(const uint8_t *in, size_t size, ChunkStorage &data)
+{
+    std::vector<uint8_t> serialized;
+    if (!lzDecompress(in, size, serialized))
+        return false;
+    return data.deserialize(serialized.data(), serialized.size());
+}
@@ -1,177 +1,266 @@
 #include "world/chunkData.h"
+#include "world/chunkStorage.h"
 #include "world/chunkMesh.h"
 #include "world/world.h"
+#include "world/chunkCodec.h"
+#include "world/batchNoise.h"
+#include "world/columnRandom.h"
+#include "structures/oak_tree.h"
+#include "threading.h"
 #include "block.h"
 
+#include <algorithm>
 #include <random>
 
 #include <iostream>
 
-#include <cstdlib> // For std::rand and std::srand
-#include <ctime>   // For std::time
+
+static const BatchPerlin batchPerlin(perlin);
 
 bool World::chunkDataExists(ChunkPos pos)
 {
+    return chunkDataMap.contains(pos) || coldChunkMap.contains(pos);
+}
 
-    if (chunkDataMap.find(pos) == chunkDataMap.end())
-        return false;
-    return true;
+// The caller must hold data_mtx. A chunk in the cold tier is decoded back
+// into chunkDataMap on first access. If its encoded copy turns out to be
+// corrupt the chunk is loaded from the region store instead, and is missing
+// if the store doesn't have it either.
+ChunkSnapshot *World::findChunkData(ChunkPos pos)
+{
+    ChunkSnapshot *data = chunkDataMap.find(pos);
+    if (data)
+    {
+        residency.touch(pos);
+        return data;
+    }
+
+    ColdChunk *cold = coldChunkMap.find(pos);
+    if (!cold)
+        return nullptr;
+
+    std::shared_ptr<ChunkStorage> thawed = std::make_shared<ChunkStorage>();
+    bool valid = decodeChunk(cold->encoded.data(), cold->encoded.size(), *thawed);
+    bool clean = cold->clean;
+    coldChunkMap.erase(pos);
+    residency.setBytes(pos, COLD_TIER, 0);
+
+    ChunkSnapshot snapshot = thawed;
+    if (valid && clean)
+    {
+        regionStore.markClean(pos, snapshot);
+    }
+    else if (!valid)
+    {
+        std::cout << "Corrupt cold chunk at: " << pos.x << ", " << pos.z << ", loading it from the region store" << std::endl;
+        snapshot = regionStore.load(pos);
+        if (!snapshot)
+            return nullptr;
+        snapshot = catchUpStoredChunk(pos, snapshot);
+    }
+
+    insertChunkData(pos, snapshot);
+    residency.touch(pos);
+    return chunkDataMap.find(pos);
 }
 
-void generateWater(std::vector<char> &data, ChunkPos pos)
+// The caller must hold data_mtx. A stale chunk from the other side of the
+// grid that hasn't been evicted yet is saved before its cell is reused.
+void World::insertChunkData(ChunkPos pos, ChunkSnapshot data)
 {
-    for (int i = 0; i < CHUNK_SIZE; i++)
+    ChunkPos stalePos;
+    ChunkSnapshot *stale = chunkDataMap.findOccupant(pos, stalePos);
+    if (stale)
     {
-        for (int k = 0; k < CHUNK_SIZE; k++)
+        regionStore.save(stalePos, *stale);
+        residency.setBytes(stalePos, DATA_TIER, 0);
+    }
+
+    coldChunkMap.erase(pos);
+    residency.setBytes(pos, COLD_TIER, 0);
+    residency.setBytes(pos, DATA_TIER, data->memoryUsage());
+    chunkDataMap.insert(pos, std::move(data));
+}
+
+// Hands a cold chunk to the region store unless the store already has it.
+// Called with data_mtx held so the chunk is queued before it leaves the cold
+// map, a load in between would otherwise find it nowhere and regenerate it.
+void World::saveColdChunk(ChunkPos pos, ColdChunk &cold)
+{
+    if (!cold.clean)
+        regionStore.saveEncoded(pos, std::move(cold.encoded));
+}
+
+// Floods every column from its surface up to the water level. Runs after
+// the caves, which stay dry below the surface.
+void generateWater(ChunkStorage &data)
+{
+    // Sections at or below the lowest column are solid all the way across
+    int lowestHeight = data.getMinHeight();
+    for (int section = std::max(lowestHeight + 1, 0) / SECTION_HEIGHT; section * SECTION_HEIGHT <= WATER_LEVEL; section++)
+    {
+        int sectionBottom = section * SECTION_HEIGHT;
+        int sectionTop = sectionBottom + SECTION_HEIGHT - 1;
+
+        // Solid sections have nothing to flood and empty ones below the
+        // water line flood completely
+        const ChunkSection &chunkSection = data.getSection(section);
+        if (chunkSection.isUniform())
         {
-            for (int j = 0; j < CHUNK_HEIGHT; j++)
+            if (!chunkSection.isEmpty())
+                continue;
+            if (sectionTop <= WATER_LEVEL)
             {
-                if (j > WATER_LEVEL)
-                    continue;
+                data.fillSection(section, BLOCK::WATER_BLOCK);
+                continue;
+            }
+        }
 
-                if (data[i + (j * CHUNK_SIZE) + (k * CHUNK_SIZE * CHUNK_HEIGHT)] == BLOCK::AIR_BLOCK)
-                {
-                    data[i + (j * CHUNK_SIZE) + (k * CHUNK_SIZE * CHUNK_HEIGHT)] = BLOCK::WATER_BLOCK;
-                }
+        int waterTop = std::min(sectionTop, WATER_LEVEL);
+        for (int i = 0; i < CHUNK_SIZE; i++)
+        {
+            for (int k = 0; k < CHUNK_SIZE; k++)
+            {
+                int waterBottom = std::max(sectionBottom, data.getHeight(i, k) + 1);
+                data.fillColumn(i, k, waterBottom, waterTop, BLOCK::WATER_BLOCK);
             }
         }
     }
 }
-inline int positiveMod(int value, int mod)
+
+BIOME classifyBiome(double regionNoise)
 {
-    return (value % mod + mod) % mod;
+    if (regionNoise < 0.4)
+        return PLAINS_BIOME;
+    if (regionNoise < 0.7)
+        return HILLS_BIOME;
+    return MOUNTAINS_BIOME;
 }
 
-void World::addStructureBlockToWorld(ChunkPos &pos, BlockWithPos &blockWithPos, std::vector<char> &data)
+// Where structures overlap, trunks stay and leaves give way no matter which
+// was placed first, so neighbouring chunks can be generated in any order
+bool structureBlockReplaces(BLOCK placed, BLOCK existing)
 {
-    auto index = [&](int x, int y, int z) -> int
-    {
-        return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    };
-
-    // Check if block is within the current chunk's boundaries
-    if (blockWithPos.x >= 0 && blockWithPos.x < CHUNK_SIZE &&
-        blockWithPos.y >= 0 && blockWithPos.y < CHUNK_HEIGHT &&
-        blockWithPos.z >= 0 && blockWithPos.z < CHUNK_SIZE)
-    {
-        // Block is inside the current chunk, update the data array
-        data[index(blockWithPos.x, blockWithPos.y, blockWithPos.z)] = blockWithPos.block;
-    }
-    else
-    {
-        // Block is outside the chunk, calculate the chunk position and add to structQueue
-        ChunkPos newChunkPos;
-        newChunkPos.x = pos.x + (blockWithPos.x < 0 ? (blockWithPos.x - CHUNK_SIZE + 1) / CHUNK_SIZE : blockWithPos.x / CHUNK_SIZE);
-        newChunkPos.z = pos.z + (blockWithPos.z < 0 ? (blockWithPos.z - CHUNK_SIZE + 1) / CHUNK_SIZE : blockWithPos.z / CHUNK_SIZE);
+    return placed == BLOCK::OAK_WOOD || existing != BLOCK::OAK_WOOD;
+}
 
-        unsigned int localX = positiveMod(blockWithPos.x, CHUNK_SIZE);
-        unsigned int localZ = positiveMod(blockWithPos.z, CHUNK_SIZE);
+// Puts one structure block in the list of the chunk it lands in. Blocks
+// reach at most one chunk past the decorated one.
+static inline void stampBlock(int x, int y, int z, BLOCK block, StructQueue &placements)
+{
+    if (y < 0 || y >= CHUNK_HEIGHT)
+        return;
 
-        BlockWithPos adjustedBlock = {localX, blockWithPos.y, localZ, blockWithPos.block};
+    int chunkX = x < 0 ? -1 : x >= CHUNK_SIZE ? 1 : 0;
+    int chunkZ = z < 0 ? -1 : z >= CHUNK_SIZE ? 1 : 0;
+    placements.chunks[(chunkZ + 1) * 3 + chunkX + 1].push_back({x - chunkX * CHUNK_SIZE, y, z - chunkZ * CHUNK_SIZE, block});
+}
 
-        if (chunkDataMap.find(newChunkPos) != chunkDataMap.end())
+// Stamps a compiled structure with its origin on column x, z of the
+// decorated chunk at height y. Each chance block is placed when the column's
+// next draw is below chance, the draws are made whether or not it fits.
+template <size_t Count, size_t ChanceCount>
+static void stampStructure(const Structure::Template<Count, ChanceCount> &structure, int x, int y, int z, ColumnRandom &random, float chance, StructQueue &placements)
+{
+    // Entirely inside the chunk, so everything goes straight to its own list
+    if (x + structure.minX >= 0 && x + structure.maxX < CHUNK_SIZE && z + structure.minZ >= 0 && z + structure.maxZ < CHUNK_SIZE &&
+        y + structure.minY >= 0 && y + structure.maxY < CHUNK_HEIGHT)
+    {
+        std::vector<BlockWithPos> &own = placements.chunks[STRUCT_QUEUE_CHUNKS / 2];
+        own.reserve(own.size() + structure.count + structure.chanceCount);
+        for (size_t i = 0; i < structure.count; i++)
         {
-            auto &data = chunkDataMap[newChunkPos];
-            data[index(adjustedBlock.x, adjustedBlock.y, adjustedBlock.z)] = adjustedBlock.block;
+            const Structure::Offset &offset = structure.blocks[i];
+            own.push_back({x + offset.x, y + offset.y, z + offset.z, offset.block});
         }
-        else
+        for (size_t i = 0; i < structure.chanceCount; i++)
         {
-            structQueue[newChunkPos].push_back(adjustedBlock);
+            const Structure::Offset &offset = structure.chanceBlocks[i];
+            if (random.nextFloat() < chance)
+                own.push_back({x + offset.x, y + offset.y, z + offset.z, offset.block});
         }
+        return;
+    }
+
+    for (size_t i = 0; i < structure.count; i++)
+    {
+        const Structure::Offset &offset = structure.blocks[i];
+        stampBlock(x + offset.x, y + offset.y, z + offset.z, offset.block, placements);
+    }
+    for (size_t i = 0; i < structure.chanceCount; i++)
+    {
+        const Structure::Offset &offset = structure.chanceBlocks[i];
+        if (random.nextFloat() < chance)
+            stampBlock(x + offset.x, y + offset.y, z + offset.z, offset.block, placements);
     }
 }
 
-void World::generateStructures(std::vector<char> &data, ChunkPos pos)
+// stampBlock only knows the chunks right next to the decorated one
+static_assert(-Structure::OAK_TREE.minX <= CHUNK_SIZE && Structure::OAK_TREE.maxX < 2 * CHUNK_SIZE &&
+                  -Structure::OAK_TREE.minZ <= CHUNK_SIZE && Structure::OAK_TREE.maxZ < 2 * CHUNK_SIZE,
+              "structure reaches past the neighbouring chunks");
+
+void placeStructureBlocks(ChunkStorage &data, const std::vector<BlockWithPos> &blocks)
 {
-    // Lambda to calculate index in the data vector
-    auto index = [&](int x, int y, int z) -> int
+    for (const BlockWithPos &block : blocks)
     {
-        return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    };
+        if (structureBlockReplaces(block.block, data.get(block.x, block.y, block.z)))
+            data.set(block.x, block.y, block.z, block.block);
+    }
+}
 
-    // Generate region noise to determine blending weight between plains, hills, and mountains
-    float regionFreq = 0.005;
-    std::string biome;
+// Hands the blocks a decoration left in other chunks to them. Decorated
+// chunks are edited right away, with the player's edits put back on top,
+// and added to changed. The rest get them spilled until their own
+// decoration, so what they decorate from is always their plain terrain.
+// The caller must hold data_mtx.
+void World::queueStructureBlocks(ChunkPos pos, StructQueue &placements, std::vector<ChunkPos> &changed)
+{
+    for (int i = 0; i < STRUCT_QUEUE_CHUNKS; i++)
+    {
+        std::vector<BlockWithPos> &blocks = placements.chunks[i];
+        if (blocks.empty())
+            continue;
 
+        ChunkPos target = {pos.x + i % 3 - 1, pos.z + i / 3 - 1};
+        ChunkSnapshot *existing = findChunkData(target);
+        if (!existing || (*existing)->getStage() != DECORATED_STAGE)
+        {
+            spillStore.append(target, blocks.data(), blocks.size());
+            continue;
+        }
+
+        std::shared_ptr<ChunkStorage> edited = std::make_shared<ChunkStorage>(**existing);
+        placeStructureBlocks(*edited, blocks);
+        editJournal.replay(target, *edited);
+        *existing = edited;
+        residency.setBytes(target, DATA_TIER, edited->memoryUsage());
+        changed.push_back(target);
+    }
+}
+
+// Only reads the chunk being decorated, so it runs without any lock. Each
+// column draws from its own ColumnRandom.
+void World::generateStructures(const ChunkStorage &data, ChunkPos pos, StructQueue &placements)
+{
     // Randomly decide to generate a tree
     float treeChance = 0.005; // 1% chance to generate a tree per column
+    float leafChance = 0.65f;
     for (int x = 0; x < CHUNK_SIZE; x++)
     {
         for (int z = 0; z < CHUNK_SIZE; z++)
         {
-            double regionNoise = perlin.octave2D_01(regionFreq * (pos.x * CHUNK_SIZE + x), regionFreq * (pos.z * CHUNK_SIZE + z), 4);
-
-            // Determine the biome based on regionNoise
-            if (regionNoise < 0.4)
-            {
-                biome = "Plains";
-            }
-            else if (regionNoise >= 0.4 && regionNoise < 0.7)
+            if (data.getBiome(x, z) == HILLS_BIOME)
             {
-                biome = "Hills";
-            }
-            else
-            {
-                biome = "Mountains";
-            }
-
-            if (biome == "Hills")
-            {
-                if (rand() / (float)RAND_MAX < treeChance)
+                ColumnRandom random(seed, pos.x * CHUNK_SIZE + x, pos.z * CHUNK_SIZE + z);
+                if (random.nextFloat() < treeChance)
                 {
-                    // std::cout << "MAKING TREEE!" << std::endl;
-                    //  Find ground level to place the tree
-                    for (int y = CHUNK_HEIGHT - 1; y >= 0; y--)
+                    // Find ground level to place the tree, nothing above the surface is grass
+                    for (int y = data.getHeight(x, z); y >= 0; y--)
                     {
-                        if (data[index(x, y, z)] == BLOCK::GRASS_BLOCK)
+                        if (data.get(x, y, z) == BLOCK::GRASS_BLOCK)
                         {
-                            int trunkHeight = 8;
-                            int leavesStartY = y + trunkHeight - 2;
-                            int leavesTopHeight = 3;
-                            int leavesRadius = 2;
-                            float leafChance = 0.65f;
-
-                            // Generate top layer of leaves
-                            for (int lx = -1; lx <= 1; lx++)
-                            {
-                                for (int lz = -1; lz <= 1; lz++)
-                                {
-                                    int leafX = x + lx;
-                                    int leafZ = z + lz;
-                                    int leafY = leavesStartY + leavesTopHeight;
-
-                                    BlockWithPos block = {leafX, leafY, leafZ, BLOCK::OAK_LEAVES};
-                                    addStructureBlockToWorld(pos, block, data);
-                                }
-                            }
-
-                            // Generate cubic leaf canopy
-                            for (int lx = -leavesRadius; lx <= leavesRadius; lx++)
-                            {
-                                for (int lz = -leavesRadius; lz <= leavesRadius; lz++)
-                                {
-                                    for (int ly = 0; ly <= 2; ly++)
-                                    {
-                                        if ((lz < 2 && lx < 2) || (rand() / (float)RAND_MAX < leafChance))
-                                        {
-                                            int leafX = x + lx;
-                                            int leafZ = z + lz;
-                                            int leafY = leavesStartY + ly;
-
-                                            BlockWithPos block = {leafX, leafY, leafZ, BLOCK::OAK_LEAVES};
-                                            addStructureBlockToWorld(pos, block, data);
-                                        }
-                                    }
-                                }
-                            }
-
-                            for (int t = 0; t < trunkHeight; t++)
-                            {
-                                int trunkY = y + t;
-                                BlockWithPos block = {x, trunkY, z, BLOCK::OAK_WOOD};
-                                addStructureBlockToWorld(pos, block, data);
-                            }
-
+                            stampStructure(Structure::OAK_TREE, x, y, z, random, leafChance, placements);
                             break;
                         }
                     }
@@ -179,89 +268,222 @@ void World::generateStructures(std::vector<char> &data, ChunkPos pos)
             }
         }
     }
+}
 
-    // Pop from the queue to get the block data for the current chunk
-    auto &queue = structQueue[pos];
-    while (!queue.empty())
-    {
-        BlockWithPos block = queue.front(); // Get the block at the front of the queue
-        queue.pop_front();                  // Remove it from the queue
-
-        // Calculate index and place the block in the data vector
-        if (block.y < CHUNK_HEIGHT) // Ensure the block is within bounds
-        {
-            data[index(block.x, block.y, block.z)] = block.block; // Update the data vector with the block
-        }
-    }
+// Places the blocks that structures in neighbouring chunks left for this
+// one. The caller must hold data_mtx, so nothing is spilled for the chunk
+// between taking its blocks and it being marked decorated.
+void World::applyQueuedStructureBlocks(ChunkStorage &data, ChunkPos pos)
+{
+    placeStructureBlocks(data, spillStore.take(pos));
 }
 
-void generateCaves(std::vector<char> &data, ChunkPos pos)
+bool isCarvable(BLOCK block)
 {
-    double freq = 0.05;    // Reduced frequency for larger caves
-    double density = 0.28; // Adjust density to make caves rarer
+    return block != BLOCK::AIR_BLOCK && block != BLOCK::BEDROCK_BLOCK && block != BLOCK::SAND_BLOCK && block != BLOCK::WATER_BLOCK;
+}
+
+#define CAVE_TOP 80
+#define CAVE_FREQ 0.05    // Reduced frequency for larger caves
+#define CAVE_DENSITY 0.28 // Adjust density to make caves rarer
+#define CAVE_CELL_WIDTH 4
+#define CAVE_CELL_HEIGHT 8
+#define CAVE_LATTICE_POINTS (CHUNK_SIZE / CAVE_CELL_WIDTH + 1)
+
+bool exact_caves = false;
+bool log_chunk_generation = true;
 
-    for (int i = 0; i < CHUNK_SIZE; i++)
+// Reference version of the cave pass, with the full noise at every voxel
+void generateExactCaves(ChunkStorage &data, ChunkPos pos)
+{
+    for (int section = 0; section * SECTION_HEIGHT <= CAVE_TOP; section++)
     {
-        for (int j = 0; j < CHUNK_HEIGHT; j++)
+        int sectionBottom = section * SECTION_HEIGHT;
+        int sectionTop = sectionBottom + SECTION_HEIGHT - 1;
+
+        // A uniform section of air, water, sand or bedrock can't be carved
+        const ChunkSection &chunkSection = data.getSection(section);
+        if (chunkSection.isUniform() && !isCarvable(chunkSection.get(0, 0, 0)))
+            continue;
+
+        for (int i = 0; i < CHUNK_SIZE; i++)
         {
-            for (int k = 0; k < CHUNK_SIZE; k++)
+            for (int j = sectionBottom; j <= sectionTop; j++)
             {
-                if (j > 80)
+                if (j > CAVE_TOP)
                     continue;
-                // Generate noise value
-                double noise = perlin.octave3D_01(freq * (pos.x * CHUNK_SIZE + i), freq * j, freq * (pos.z * CHUNK_SIZE + k), 12);
 
-                // Adjust the condition to create rarer but larger caves
-                if (noise < (0.60 - density))
+                // Noise for the whole row along z in one batch
+                double noiseX[CHUNK_SIZE], noiseY[CHUNK_SIZE], noiseZ[CHUNK_SIZE], noise[CHUNK_SIZE];
+                for (int k = 0; k < CHUNK_SIZE; k++)
                 {
-                    BLOCK block = (BLOCK)data[i + (j * CHUNK_SIZE) + (k * CHUNK_SIZE * CHUNK_HEIGHT)];
-                    if (block == BLOCK::BEDROCK_BLOCK || block == BLOCK::SAND_BLOCK || block == BLOCK::WATER_BLOCK)
-                        continue;
-                    data[i + (j * CHUNK_SIZE) + (k * CHUNK_SIZE * CHUNK_HEIGHT)] = BLOCK::AIR_BLOCK;
+                    noiseX[k] = CAVE_FREQ * (pos.x * CHUNK_SIZE + i);
+                    noiseY[k] = CAVE_FREQ * j;
+                    noiseZ[k] = CAVE_FREQ * (pos.z * CHUNK_SIZE + k);
+                }
+                batchPerlin.octave3D_01(noiseX, noiseY, noiseZ, noise, CHUNK_SIZE, 12);
+
+                for (int k = 0; k < CHUNK_SIZE; k++)
+                {
+                    // Adjust the condition to create rarer but larger caves
+                    if (noise[k] < (0.60 - CAVE_DENSITY))
+                    {
+                        if (!isCarvable(data.get(i, j, k)))
+                            continue;
+                        data.set(i, j, k, BLOCK::AIR_BLOCK);
+                    }
                 }
             }
         }
     }
 }
 
-void World::generateChunkData(ChunkPos pos)
+// The cave density is sampled on a lattice of 4x8x4 block cells and
+// trilinearly interpolated in between, about 300 noise samples per chunk
+// instead of one per voxel. Lattice points sit on chunk borders too, so the
+// neighbouring chunks interpolate the same values there. Cells above the
+// terrain of all their columns or below the top of the bedrock are skipped.
+//
+// The lattice is sampled per row along x and carved per section. Carving only
+// turns blocks into air, so the sections come out the same in any order, and
+// the heights it reads are those of the terrain until rebuildColumns.
+void generateCaves(ChunkStorage &data, ChunkPos pos, TaskScheduler &scheduler)
 {
-    // std::cout << "generating chunk: (" << pos.x << ", " << pos.z << ")" << std::endl;
-    std::vector<char> data(BLOCKS_PER_CHUNK);
+    if (exact_caves)
+    {
+        generateExactCaves(data, pos);
+        return;
+    }
 
-    // Lambda to calculate index in the data vector
-    auto index = [&](int x, int y, int z) -> int
+    int highestTerrain = data.getMaxHeight();
+    int layers = std::min(highestTerrain, CAVE_TOP) / CAVE_CELL_HEIGHT + 2;
+
+    double noiseX[CAVE_LATTICE_POINTS * CAVE_LATTICE_POINTS * (CAVE_TOP / CAVE_CELL_HEIGHT + 2)];
+    double noiseY[sizeof(noiseX) / sizeof(double)], noiseZ[sizeof(noiseX) / sizeof(double)], lattice[sizeof(noiseX) / sizeof(double)];
+    auto latticeIndex = [&](int lx, int ly, int lz)
     {
-        return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
+        return (lx * CAVE_LATTICE_POINTS + lz) * layers + ly;
     };
+    scheduler.parallelFor(CAVE_LATTICE_POINTS, [&](int lx)
+                          {
+        for (int lz = 0; lz < CAVE_LATTICE_POINTS; lz++)
+        {
+            for (int ly = 0; ly < layers; ly++)
+            {
+                noiseX[latticeIndex(lx, ly, lz)] = CAVE_FREQ * (pos.x * CHUNK_SIZE + lx * CAVE_CELL_WIDTH);
+                noiseY[latticeIndex(lx, ly, lz)] = CAVE_FREQ * (ly * CAVE_CELL_HEIGHT);
+                noiseZ[latticeIndex(lx, ly, lz)] = CAVE_FREQ * (pos.z * CHUNK_SIZE + lz * CAVE_CELL_WIDTH);
+            }
+        }
+        int row = latticeIndex(lx, 0, 0);
+        batchPerlin.octave3D_01(noiseX + row, noiseY + row, noiseZ + row, lattice + row, CAVE_LATTICE_POINTS * layers, 12); });
+
+    int cellTerrains[CHUNK_SIZE / CAVE_CELL_WIDTH][CHUNK_SIZE / CAVE_CELL_WIDTH] = {};
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            int &cellTerrain = cellTerrains[x / CAVE_CELL_WIDTH][z / CAVE_CELL_WIDTH];
+            cellTerrain = std::max(cellTerrain, data.getHeight(x, z));
+        }
+    }
+
+    static_assert(SECTION_HEIGHT % CAVE_CELL_HEIGHT == 0, "cave cells must not cross sections");
+    int sections = ((layers - 1) * CAVE_CELL_HEIGHT + SECTION_HEIGHT - 1) / SECTION_HEIGHT;
+    scheduler.parallelFor(sections, [&](int section)
+                          {
+        // A uniform section of air, water, sand or bedrock can't be carved
+        ChunkSection &chunkSection = data.editSection(section);
+        if (chunkSection.isUniform() && !isCarvable(chunkSection.get(0, 0, 0)))
+            return;
+
+        int sectionBottom = section * SECTION_HEIGHT;
+        int firstCell = sectionBottom / CAVE_CELL_HEIGHT;
+        int lastCell = std::min(firstCell + SECTION_HEIGHT / CAVE_CELL_HEIGHT, layers - 1);
+        for (int cellX = 0; cellX < CHUNK_SIZE / CAVE_CELL_WIDTH; cellX++)
+        {
+            for (int cellZ = 0; cellZ < CHUNK_SIZE / CAVE_CELL_WIDTH; cellZ++)
+            {
+                int cellTerrain = cellTerrains[cellX][cellZ];
+                for (int cellY = firstCell; cellY < lastCell; cellY++)
+                {
+                    int cellBottom = cellY * CAVE_CELL_HEIGHT;
+                    int cellTop = cellBottom + CAVE_CELL_HEIGHT - 1;
+                    if (cellBottom > cellTerrain || cellBottom > CAVE_TOP)
+                        break;
+                    if (cellTop < BEDROCK_HEIGHT)
+                        continue;
+
+                    double c000 = lattice[latticeIndex(cellX, cellY, cellZ)];
+                    double c100 = lattice[latticeIndex(cellX + 1, cellY, cellZ)];
+                    double c001 = lattice[latticeIndex(cellX, cellY, cellZ + 1)];
+                    double c101 = lattice[latticeIndex(cellX + 1, cellY, cellZ + 1)];
+                    double c010 = lattice[latticeIndex(cellX, cellY + 1, cellZ)];
+                    double c110 = lattice[latticeIndex(cellX + 1, cellY + 1, cellZ)];
+                    double c011 = lattice[latticeIndex(cellX, cellY + 1, cellZ + 1)];
+                    double c111 = lattice[latticeIndex(cellX + 1, cellY + 1, cellZ + 1)];
 
-    // Lambda to assign block type based on conditions
-    auto assignBlock = [&](int x, int y, int z, bool rockyTops, bool snowyTops, bool sandyTops, int blocksInHeight)
+                    // The interpolation never goes below the lowest corner, a
+                    // cell whose corners are all above the threshold stays solid.
+                    // The margin covers rounding in the interpolation.
+                    if (std::min({c000, c100, c001, c101, c010, c110, c011, c111}) >= (0.60 - CAVE_DENSITY) + 1e-9)
+                        continue;
+
+                    for (int dx = 0; dx < CAVE_CELL_WIDTH; dx++)
+                    {
+                        double tx = dx / (double)CAVE_CELL_WIDTH;
+                        for (int dz = 0; dz < CAVE_CELL_WIDTH; dz++)
+                        {
+                            double tz = dz / (double)CAVE_CELL_WIDTH;
+                            int x = cellX * CAVE_CELL_WIDTH + dx;
+                            int z = cellZ * CAVE_CELL_WIDTH + dz;
+
+                            double bottom = c000 + (c100 - c000) * tx + (c001 - c000) * tz + (c000 - c100 - c001 + c101) * tx * tz;
+                            double top = c010 + (c110 - c010) * tx + (c011 - c010) * tz + (c010 - c110 - c011 + c111) * tx * tz;
+                            int columnTop = std::min({cellTop, data.getHeight(x, z), CAVE_TOP});
+                            for (int y = std::max(cellBottom, BEDROCK_HEIGHT); y <= columnTop; y++)
+                            {
+                                double noise = bottom + (top - bottom) * ((y - cellBottom) / (double)CAVE_CELL_HEIGHT);
+                                if (noise < (0.60 - CAVE_DENSITY) && isCarvable(chunkSection.get(x, y - sectionBottom, z)))
+                                    chunkSection.set(x, y - sectionBottom, z, BLOCK::AIR_BLOCK);
+                            }
+                        }
+                    }
+                }
+            }
+        } });
+    data.rebuildColumns();
+}
+
+// The shape stage: terrain columns from the region and terrain noise. The
+// noise is evaluated per strip of columns along z, then every section is
+// filled by its own task and the column layer is rebuilt at the end.
+void generateTerrain(ChunkStorage &data, ChunkPos pos, TaskScheduler &scheduler)
+{
+    // Lambda to pick the block type based on conditions
+    auto columnBlock = [](int y, bool rockyTops, bool snowyTops, bool sandyTops, int blocksInHeight)
     {
-        if (y < 3)
+        if (y < BEDROCK_HEIGHT)
         {
-            data[index(x, y, z)] = BLOCK::BEDROCK_BLOCK;
+            return BLOCK::BEDROCK_BLOCK;
         }
         else if (blocksInHeight >= 3)
         {
-            data[index(x, y, z)] = BLOCK::STONE_BLOCK;
+            return BLOCK::STONE_BLOCK;
         }
         else if (rockyTops)
         {
-            data[index(x, y, z)] = BLOCK::STONE_BLOCK;
+            return BLOCK::STONE_BLOCK;
         }
         else if (snowyTops)
         {
-            data[index(x, y, z)] = BLOCK::SNOW_BLOCK;
+            return BLOCK::SNOW_BLOCK;
         }
         else if (sandyTops)
         {
-            data[index(x, y, z)] = BLOCK::SAND_BLOCK;
-        }
-        else
-        {
-            data[index(x, y, z)] = (blocksInHeight >= 1) ? BLOCK::DIRT_BLOCK : BLOCK::GRASS_BLOCK;
+            return BLOCK::SAND_BLOCK;
         }
+        return (blocksInHeight >= 1) ? BLOCK::DIRT_BLOCK : BLOCK::GRASS_BLOCK;
     };
 
     // Lambda for linear interpolation (LERP)
@@ -272,102 +494,524 @@ void World::generateChunkData(ChunkPos pos)
 
     float regionFreq = 0.005;
 
-    // Loop through X and Z axes
-    for (int x = 0; x < CHUNK_SIZE; x++)
-    {
+    // Define frequencies and heights for different region types
+    double plainsFreq = 0.005, hillsFreq = 0.007, mountainsFreq = 0.03;
+    double plainsHeightScale = CHUNK_HEIGHT / 4, hillsHeightScale = CHUNK_HEIGHT / 2, mountainsHeightScale = CHUNK_HEIGHT - 60;
+
+    // Generate region noise to determine blending weight between plains, hills, and mountains.
+    // The noise of a strip is evaluated in batches, first the region noise and then the
+    // terrain noise at each column's blended frequency.
+    int terrainHeights[CHUNK_SIZE * CHUNK_SIZE];
+    scheduler.parallelFor(CHUNK_SIZE, [&](int x)
+                          {
+        double noiseX[CHUNK_SIZE], noiseZ[CHUNK_SIZE];
+        double regionNoise[CHUNK_SIZE], terrainNoise[CHUNK_SIZE];
+        double blendedHeightScales[CHUNK_SIZE];
         for (int z = 0; z < CHUNK_SIZE; z++)
         {
-            // Generate region noise to determine blending weight between plains, hills, and mountains
-            double regionNoise = perlin.octave2D_01(regionFreq * (pos.x * CHUNK_SIZE + x), regionFreq * (pos.z * CHUNK_SIZE + z), 4);
+            noiseX[z] = regionFreq * (pos.x * CHUNK_SIZE + x);
+            noiseZ[z] = regionFreq * (pos.z * CHUNK_SIZE + z);
+        }
+        batchPerlin.octave2D_01(noiseX, noiseZ, regionNoise, CHUNK_SIZE, 4);
 
-            // Define frequencies and heights for different region types
-            double plainsFreq = 0.005, hillsFreq = 0.007, mountainsFreq = 0.03;
-            double plainsHeightScale = CHUNK_HEIGHT / 4, hillsHeightScale = CHUNK_HEIGHT / 2, mountainsHeightScale = CHUNK_HEIGHT - 60;
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            double columnNoise = regionNoise[z];
+            data.setBiome(x, z, classifyBiome(columnNoise));
 
             // Determine blend weights based on regionNoise
-            double plainsWeight = (regionNoise < 0.4) ? (1.0 - regionNoise / 0.4) : 0.0;                      // Strong in plains zone
-            double hillsWeight = (regionNoise >= 0.4 && regionNoise < 0.7) ? (regionNoise - 0.4) / 0.3 : 0.0; // Middle zone (hills)
-            double mountainsWeight = (regionNoise >= 0.7) ? (regionNoise - 0.7) / 0.5 : 0.0;                  // Strong in mountain zone
+            double plainsWeight = (columnNoise < 0.4) ? (1.0 - columnNoise / 0.4) : 0.0;     // Strong in plains zone
+            double mountainsWeight = (columnNoise >= 0.7) ? (columnNoise - 0.7) / 0.5 : 0.0; // Strong in mountain zone
 
             // Blend frequency and height scales based on weights
             double blendedFreq = lerp(lerp(plainsFreq, hillsFreq, plainsWeight), mountainsFreq, mountainsWeight);
-            double blendedHeightScale = lerp(lerp(plainsHeightScale, hillsHeightScale, plainsWeight), mountainsHeightScale, mountainsWeight);
+            blendedHeightScales[z] = lerp(lerp(plainsHeightScale, hillsHeightScale, plainsWeight), mountainsHeightScale, mountainsWeight);
 
-            // Get terrain noise using blended frequency
-            double noise = perlin.octave2D_01(blendedFreq * (pos.x * CHUNK_SIZE + x), blendedFreq * (pos.z * CHUNK_SIZE + z), 12);
+            noiseX[z] = blendedFreq * (pos.x * CHUNK_SIZE + x);
+            noiseZ[z] = blendedFreq * (pos.z * CHUNK_SIZE + z);
+        }
 
-            // Scale terrain height based on the blended height scale
-            int terrainHeight = static_cast<int>(noise * blendedHeightScale) + (CHUNK_HEIGHT / 8);
+        // Get terrain noise using blended frequency
+        batchPerlin.octave2D_01(noiseX, noiseZ, terrainNoise, CHUNK_SIZE, 12);
 
-            bool rockyTops = (terrainHeight > 110 && terrainHeight < 118);
-            bool snowyTops = (terrainHeight >= 118);
-            bool sandyTops = (terrainHeight < WATER_LEVEL + 3);
+        // Scale terrain height based on the blended height scale
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            terrainHeights[columnIndex(x, z)] = static_cast<int>(terrainNoise[z] * blendedHeightScales[z]) + (CHUNK_HEIGHT / 8);
+        } });
 
-            int blocksInHeight = 0;
+    // Sections below the lowest stone of the chunk (and above the bedrock)
+    // are plain stone, sections above the highest column stay air. The rest
+    // is written column by column from the top down in runs of one block,
+    // the order a single pass over the whole chunk would use, so their
+    // palettes come out the same.
+    int lowestTop = CHUNK_HEIGHT - 1;
+    int highestTop = 0;
+    for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+    {
+        lowestTop = std::min(lowestTop, terrainHeights[i]);
+        highestTop = std::max(highestTop, std::min(terrainHeights[i], CHUNK_HEIGHT - 1));
+    }
 
-            // Loop through Y-axis (top-down)
-            for (int y = CHUNK_HEIGHT - 1; y >= 0; y--)
+    scheduler.parallelFor(SECTIONS_PER_CHUNK, [&](int section)
+                          {
+        ChunkSection &chunkSection = data.editSection(section);
+        int sectionBottom = section * SECTION_HEIGHT;
+        int sectionTop = sectionBottom + SECTION_HEIGHT - 1;
+        if (sectionBottom > highestTop)
+            return;
+        if (sectionBottom >= BEDROCK_HEIGHT && sectionTop <= lowestTop - 3)
+        {
+            chunkSection.fill(BLOCK::STONE_BLOCK);
+            return;
+        }
+
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
             {
-                if (y <= terrainHeight)
-                {
-                    // Fill blocks based on height and top conditions
-                    assignBlock(x, y, z, rockyTops, snowyTops, sandyTops, blocksInHeight);
-                    blocksInHeight++;
-                }
-                else
+                int terrainHeight = terrainHeights[columnIndex(x, z)];
+                int columnTop = std::min(terrainHeight, CHUNK_HEIGHT - 1);
+
+                bool rockyTops = (terrainHeight > 110 && terrainHeight < 118);
+                bool snowyTops = (terrainHeight >= 118);
+                bool sandyTops = (terrainHeight < WATER_LEVEL + 3);
+
+                int y = std::min(columnTop, sectionTop);
+                while (y >= sectionBottom)
                 {
-                    // Empty space (AIR_BLOCK) above terrain height
-                    data[index(x, y, z)] = BLOCK::AIR_BLOCK;
+                    BLOCK block = columnBlock(y, rockyTops, snowyTops, sandyTops, columnTop - y);
+                    int runBottom = y;
+                    while (runBottom > sectionBottom && columnBlock(runBottom - 1, rockyTops, snowyTops, sandyTops, columnTop - runBottom + 1) == block)
+                    {
+                        runBottom--;
+                    }
+                    chunkSection.fillColumn(x, z, runBottom - sectionBottom, y - sectionBottom, block);
+                    y = runBottom - 1;
                 }
             }
-        }
+        } });
+    data.rebuildColumns();
+}
+
+// Runs a new chunk through the stages that only need the chunk itself. They
+// take no lock, so any number of threads can generate chunks at once. The
+// chunk then waits in the map at FLUID_STAGE until it and its neighbours
+// can be decorated.
+void World::generateChunkData(ChunkPos pos)
+{
+    // std::cout << "generating chunk: (" << pos.x << ", " << pos.z << ")" << std::endl;
+    ChunkStorage data;
+    generateTerrain(data, pos, generationScheduler);
+    data.setStage(SHAPED_STAGE);
+
+    // collapse the all-stone and all-air sections before the later passes
+    data.compact();
+    generateCaves(data, pos, generationScheduler);
+    data.setStage(CARVED_STAGE);
+    generateWater(data);
+    data.setStage(FLUID_STAGE);
+    data.compact();
+
+    {
+        std::lock_guard<std::mutex> lock(data_mtx);
+        insertChunkData(pos, std::make_shared<const ChunkStorage>(std::move(data)));
     }
+    if (log_chunk_generation)
+        std::cout << "Generated chunk data at: " << pos.x << ", " << pos.z << std::endl;
+    decorateReadyChunks(pos);
+}
 
-    generateWater(data, pos);
-    generateCaves(data, pos);
+// A new chunk can complete the neighbourhood of itself or of any of the
+// eight chunks around it
+void World::decorateReadyChunks(ChunkPos pos)
+{
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+            ChunkPos candidate = {pos.x + dx, pos.z + dz};
+            if (claimDecoration(candidate))
+                decorateChunk(candidate);
+        }
+    }
+}
 
+// Claims a chunk for decoration if it is waiting at FLUID_STAGE, nobody else
+// is decorating it and all eight neighbours exist
+bool World::claimDecoration(ChunkPos pos)
+{
     std::lock_guard<std::mutex> struct_lock(struct_mtx);
+    if (decoratingChunks.count(pos))
+        return false;
+
     std::lock_guard<std::mutex> lock(data_mtx);
-    generateStructures(data, pos);
-    chunkDataMap[pos] = data;
-    std::cout << "Generated chunk data at: " << pos.x << ", " << pos.z << std::endl;
+    ChunkSnapshot *data = findChunkData(pos);
+    if (!data || (*data)->getStage() != FLUID_STAGE)
+        return false;
+
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+            if (!chunkDataExists({pos.x + dx, pos.z + dz}))
+                return false;
+        }
+    }
+
+    decoratingChunks.insert(pos);
+    return true;
+}
+
+// The decorate stage. The trees are planned from the chunk's own terrain
+// without any lock, then written to the chunk and its neighbours in one go
+// under the locks, and every chunk that changed is remeshed.
+void World::decorateChunk(ChunkPos pos)
+{
+    ChunkSnapshot base = getChunkDataIfExists(pos);
+    StructQueue placements;
+    if (base)
+        generateStructures(*base, pos, placements);
+
+    std::vector<ChunkPos> changed;
+    {
+        std::lock_guard<std::mutex> struct_lock(struct_mtx);
+        decoratingChunks.erase(pos);
+
+        // Evicted in the meantime, it is decorated again once it comes back
+        std::lock_guard<std::mutex> lock(data_mtx);
+        ChunkSnapshot *current = findChunkData(pos);
+        if (!current || (*current)->getStage() != FLUID_STAGE)
+            return;
+
+        ChunkStorage data = **current;
+        std::vector<BlockWithPos> &own = placements.chunks[STRUCT_QUEUE_CHUNKS / 2];
+        placeStructureBlocks(data, own);
+        own.clear();
+        applyQueuedStructureBlocks(data, pos);
+        editJournal.replay(pos, data);
+        data.setStage(DECORATED_STAGE);
+        data.compact();
+
+        *current = std::make_shared<const ChunkStorage>(std::move(data));
+        residency.setBytes(pos, DATA_TIER, (*current)->memoryUsage());
+        changed.push_back(pos);
+        queueStructureBlocks(pos, placements, changed);
+    }
+    queueRemeshes(changed);
 }
 
-std::vector<char> &World::getChunkDataIfExists(ChunkPos pos)
+// Chunks whose blocks changed after they may have been meshed are meshed
+// again, and so are their neighbours whose border faces depend on them
+void World::queueRemeshes(const std::vector<ChunkPos> &changed)
 {
-    if (chunkDataMap.find(pos) != chunkDataMap.end())
+    std::unique_lock<std::mutex> queue_lock(mesh_queue_mtx);
+    for (ChunkPos pos : changed)
     {
-        return chunkDataMap[pos];
+        ChunkPos affected[5] = {pos, {pos.x, pos.z - 1}, {pos.x, pos.z + 1}, {pos.x - 1, pos.z}, {pos.x + 1, pos.z}};
+        for (ChunkPos &remeshPos : affected)
+        {
+            if (chunkMeshExists(remeshPos) && !posIsInQueue(chunksToMeshQueue, remeshPos))
+                chunksToMeshQueue.push_front(remeshPos);
+        }
     }
-    std::vector<char> emptyVec;
-    return emptyVec;
+}
+
+ChunkSnapshot World::getChunkDataIfExists(ChunkPos pos)
+{
+    std::lock_guard<std::mutex> lock(data_mtx);
+    ChunkSnapshot *data = findChunkData(pos);
+    return data ? *data : nullptr;
+}
+
+// Copy on write, the caller must hold data_mtx. Returns false when the chunk
+// isn't loaded.
+bool World::editChunkData(ChunkPos pos, int x, int y, int z, BLOCK block)
+{
+    ChunkSnapshot *data = findChunkData(pos);
+    if (!data)
+        return false;
+
+    std::shared_ptr<ChunkStorage> edited = std::make_shared<ChunkStorage>(**data);
+    edited->set(x, y, z, block);
+    *data = edited;
+    residency.setBytes(pos, DATA_TIER, edited->memoryUsage());
+    return true;
 }
 
 void World::removeChunkDataFromMap(ChunkPos pos)
 {
     chunkDataMap.erase(pos);
+    residency.setBytes(pos, DATA_TIER, 0);
 }
 
-void World::removeUnneededChunkData(ChunkPos pos)
+// Moves a chunk into the cold tier. The encoding happens outside data_mtx so
+// mesh jobs aren't held up. Returns false if the chunk changed meanwhile.
+bool World::freezeChunkData(ChunkPos pos, ChunkSnapshot data)
 {
+    ColdChunk cold;
+    encodeChunk(*data, cold.encoded);
+    cold.clean = regionStore.isClean(pos, data);
+
     std::lock_guard<std::mutex> lock(data_mtx);
-    std::vector<ChunkPos> chunkPosToRemove;
-    for (const auto &pair : chunkDataMap)
+    ChunkSnapshot *current = chunkDataMap.find(pos);
+    if (!current || *current != data)
+        return false;
+
+    ChunkPos stalePos;
+    ColdChunk *stale = coldChunkMap.findOccupant(pos, stalePos);
+    if (stale)
+    {
+        saveColdChunk(stalePos, *stale);
+        residency.setBytes(stalePos, COLD_TIER, 0);
+    }
+    residency.setBytes(pos, COLD_TIER, cold.encoded.capacity());
+    coldChunkMap.insert(pos, std::move(cold));
+    removeChunkDataFromMap(pos);
+    return true;
+}
+
+// Drops a cold chunk, it is written to the region store unless the store
+// already has it
+bool World::evictColdChunk(ChunkPos pos)
+{
+    std::lock_guard<std::mutex> lock(data_mtx);
+    ColdChunk *found = coldChunkMap.find(pos);
+    if (!found)
+        return false;
+
+    saveColdChunk(pos, *found);
+    coldChunkMap.erase(pos);
+    residency.setBytes(pos, COLD_TIER, 0);
+    return true;
+}
+
+// Evicts least recently used chunks outside the visible set until the
+// world fits its memory budget again. Meshes go first since they are rebuilt
+// from data, then data drops to the cold tier, then cold chunks go to disk.
+void World::enforceMemoryBudget(ChunkPos pos)
+{
+    if (!residency.isOverBudget())
+        return;
+
+    // Everything drawn plus the neighbours the mesher needs stays resident
+    std::vector<ChunkPos> candidates = residency.getEvictionCandidates(pos, render_distance + 1);
+    for (const ChunkPos &candidate : candidates)
+    {
+        if (!residency.isOverBudget())
+            return;
+        if (evictChunkMesh(candidate))
+            residency.countEviction();
+    }
+
+    for (const ChunkPos &candidate : candidates)
     {
-        ChunkPos currPos = pair.first;
-        glm::vec2 vector = glm::vec2(currPos.x - pos.x, currPos.z - pos.z);
-        if ((int)glm::length(vector) > (render_distance + 6))
+        if (!residency.isOverBudget())
+            return;
+
+        ChunkSnapshot data;
         {
-            chunkPosToRemove.push_back(currPos);
+            std::lock_guard<std::mutex> lock(data_mtx);
+            ChunkSnapshot *found = chunkDataMap.find(candidate);
+            if (found)
+                data = *found;
         }
+        if (data && freezeChunkData(candidate, data))
+            residency.countEviction();
     }
 
-    for (const auto &pos : chunkPosToRemove)
+    for (const ChunkPos &candidate : candidates)
     {
-        removeChunkDataFromMap(pos);
+        if (!residency.isOverBudget())
+            return;
+        if (evictColdChunk(candidate))
+            residency.countEviction();
     }
 }
 
+void World::setMemoryBudget(size_t bytes)
+{
+    residency.setBudget(bytes);
+}
+
+ResidencyStats World::getResidencyStats()
+{
+    return residency.getStats();
+}
+
+SpillStats World::getSpillStats()
+{
+    return spillStore.getStats();
+}
+
+size_t World::getGenerationThreadCount()
+{
+    return generationScheduler.getThreadCount();
+}
+
+// Loads or generates every chunk on the generation workers and returns once
+// all of them are in memory. Chunks whose neighbours are all there by then
+// are decorated as usual.
+void World::generateChunks(const std::vector<ChunkPos> &positions)
+{
+    generationScheduler.parallelFor(positions.size(), [&](int i)
+                                    { loadOrGenerateChunkData(positions[i]); });
+}
+
+// Drops a chunk from memory, writing it to the region store first if save
+// is set. Saving a chunk that was loaded and never changed writes nothing.
+void World::unloadChunkData(ChunkPos pos, bool save)
+{
+    std::lock_guard<std::mutex> lock(data_mtx);
+    ChunkSnapshot *data = chunkDataMap.find(pos);
+    if (!data)
+        return;
+
+    if (save)
+        regionStore.save(pos, *data);
+    removeChunkDataFromMap(pos);
+}
+
+void World::flushRegionStore()
+{
+    regionStore.flush();
+}
+
+size_t World::getRegionBytesWritten()
+{
+    return regionStore.getBytesWritten();
+}
+
+// Chunks past the retention radius go to the region store. Chunks between
+// the mesh radius and the retention radius are moved to the cold tier.
+void World::removeUnneededChunkData(ChunkPos pos)
+{
+    std::vector<std::pair<ChunkPos, ChunkSnapshot>> chunksToFreeze;
+    {
+        std::lock_guard<std::mutex> lock(data_mtx);
+        std::vector<ChunkPos> chunkPosToRemove;
+        chunkDataMap.forEach([&](ChunkPos currPos, ChunkSnapshot &data)
+                             {
+            glm::vec2 vector = glm::vec2(currPos.x - pos.x, currPos.z - pos.z);
+            int distance = (int)glm::length(vector);
+            if (distance > (render_distance + 6))
+            {
+                chunkPosToRemove.push_back(currPos);
+            }
+            else if (distance > (render_distance + 4))
+            {
+                chunksToFreeze.push_back({currPos, data});
+            } });
+
+        for (const auto &pos : chunkPosToRemove)
+        {
+            regionStore.save(pos, *chunkDataMap.find(pos));
+            removeChunkDataFromMap(pos);
+        }
+
+        std::vector<ChunkPos> coldPosToRemove;
+        coldChunkMap.forEach([&](ChunkPos currPos, ColdChunk &cold)
+                             {
+            glm::vec2 vector = glm::vec2(currPos.x - pos.x, currPos.z - pos.z);
+            if ((int)glm::length(vector) > (render_distance + 6))
+            {
+                saveColdChunk(currPos, cold);
+                coldPosToRemove.push_back(currPos);
+            } });
+
+        for (const auto &currPos : coldPosToRemove)
+        {
+            coldChunkMap.erase(currPos);
+            residency.setBytes(currPos, COLD_TIER, 0);
+        }
+    }
+
+    for (const auto &pair : chunksToFreeze)
+    {
+        freezeChunkData(pair.first, pair.second);
+    }
+
+    // Spills for chunks that left with the retention radius are kept a while
+    // in case the player turns back
+    spillStore.cleanup(pos, render_distance + 6, std::chrono::seconds(SPILL_TTL_SECONDS));
+
+    enforceMemoryBudget(pos);
+}
+
+// Chunks that were evicted earlier come back from the region files, only
+// chunks that were never generated go through the noise pipeline
+void World::loadOrGenerateChunkData(ChunkPos pos)
+{
+    ChunkSnapshot stored = regionStore.load(pos);
+    if (!stored)
+    {
+        generateChunkData(pos);
+        return;
+    }
+
+    {
+        // Structures generated next to this chunk while it was on disk, and
+        // edits newer than the stored copy if the game quit before it was
+        // saved again. A chunk that was evicted before its decoration keeps
+        // them queued until then.
+        std::lock_guard<std::mutex> lock(data_mtx);
+        insertChunkData(pos, catchUpStoredChunk(pos, stored));
+    }
+    decorateReadyChunks(pos);
+}
+
+// Brings a decorated chunk read back from the region store up to date with
+// the structure blocks and edits queued for it. The caller must hold
+// data_mtx.
+ChunkSnapshot World::catchUpStoredChunk(ChunkPos pos, ChunkSnapshot stored)
+{
+    if (stored->getStage() != DECORATED_STAGE || (!spillStore.hasPending(pos) && !editJournal.hasEdits(pos)))
+        return stored;
+
+    ChunkStorage data = *stored;
+    applyQueuedStructureBlocks(data, pos);
+    editJournal.replay(pos, data);
+    data.compact();
+    return std::make_shared<const ChunkStorage>(std::move(data));
+}
+
+// Queues a chunk for loading or generation on the generation pool, unless
+// it exists or is queued already
+void World::requestChunkData(ChunkPos pos)
+{
+    {
+        std::lock_guard<std::mutex> lock(data_mtx);
+        if (chunkDataExists(pos))
+            return;
+    }
+
+    std::lock_guard<std::mutex> lock(generation_mtx);
+    if (!chunksInGeneration.insert(pos).second)
+        return;
+
+    generationScheduler.submit([this, pos]
+                               {
+        ChunkPos currPos;
+        {
+            std::unique_lock<std::mutex> lock(pos_mtx);
+            currPos = worldCurrPos;
+        }
+
+        // The player may have moved on while the chunk waited in the queue
+        int dx = pos.x - currPos.x;
+        int dz = pos.z - currPos.z;
+        bool exists;
+        {
+            std::lock_guard<std::mutex> lock(data_mtx);
+            exists = chunkDataExists(pos);
+        }
+        if (!exists && dx * dx + dz * dz <= (render_distance + 4) * (render_distance + 4))
+            loadOrGenerateChunkData(pos);
+
+        std::lock_guard<std::mutex> lock(generation_mtx);
+        chunksInGeneration.erase(pos); });
+}
+
 void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
 {
     int x = pos.x;
@@ -376,7 +1020,7 @@ void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
     ChunkPos currPos = pos;
     if (!chunkDataExists(currPos))
     {
-        generateChunkData(currPos);
+        requestChunkData(currPos);
     }
 
     int range = render_distance + 1;
@@ -392,7 +1036,7 @@ void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
             currPos = {x - i + j, z + i};
             if (!chunkDataExists(currPos))
             {
-                generateChunkData(currPos);
+                requestChunkData(currPos);
             }
         }
         // start top right
@@ -401,7 +1045,7 @@ void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
             currPos = {x + i, z + i - j};
             if (!chunkDataExists(currPos))
             {
-                generateChunkData(currPos);
+                requestChunkData(currPos);
             }
         }
         // start bottom right
@@ -410,7 +1054,7 @@ void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
             currPos = {x + i - j, z - i};
             if (!chunkDataExists(currPos))
             {
-                generateChunkData(currPos);
+                requestChunkData(currPos);
             }
         }
         // start bottom left
@@ -419,7 +1063,7 @@ void World::generateChunkDataFromPos(ChunkPos pos, bool initial = false)
             currPos = {x - i, z - i + j};
             if (!chunkDataExists(currPos))
             {
-                generateChunkData(currPos);
+                requestChunkData(currPos);
             }
         }
     }
@@ -487,5 +1131,5 @@ void World::generateNextData()
     ChunkPos pos = chunkDataQueue.front();
     chunkDataQueue.pop_front();
 
-    generateChunkData(pos);
+    loadOrGenerateChunkData(pos);
 }
\ No newline at end of file
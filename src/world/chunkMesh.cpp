@@ -3,9 +3,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <algorithm>
 
 #include "world/chunkMesh.h"
+#include "world/chunkStorage.h"
 #include "world/world.h"
 
 #include "glError.h"
@@ -13,19 +17,20 @@
 #include "block.h"
 
 int render_distance = 12;
+bool greedy_meshing = true;
 
 void World::bindChunkOpaque(ChunkMesh &chunkMesh)
 {
     GLCall(glBindVertexArray(chunkMesh.VAO_opaque));
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, chunkMesh.VBO_opaque));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkMesh.EBO_opaque));
+    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer));
 }
 
 void World::bindChunkTransparent(ChunkMesh &chunkMesh)
 {
     GLCall(glBindVertexArray(chunkMesh.VAO_transparent));
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, chunkMesh.VBO_transparent));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkMesh.EBO_transparent));
+    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer));
 }
 
 void World::unbindChunk(ChunkMesh &chunkMesh)
@@ -35,172 +40,277 @@ void World::unbindChunk(ChunkMesh &chunkMesh)
     GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 }
 
-typedef struct
+// Works on rows of 16 voxels along x, bit x of a row being the voxel at x.
+// A row's neighbours towards -x and +x are the row itself shifted by one,
+// with the missing bit taken from the next chunk over, every other neighbour
+// is a whole row of its own. Solid blocks show a face where the neighbour is
+// not opaque, water where it is not occupied, and water's top only where
+// there is no water above it.
+static_assert(CHUNK_SIZE == 16, "cullSectionFaces holds a row of voxels in a uint16_t");
+void cullSectionFaces(ChunkData &chunkData, int section, SectionFaces &faces)
 {
-    std::vector<char> chunkData;
-    std::vector<char> northChunkData;
-    std::vector<char> southChunkData;
-    std::vector<char> westChunkData;
-    std::vector<char> eastChunkData;
-} ChunkData;
-
-void updateLiquidRenderInfo(BLOCK block, int x, int y, int z, LiquidRenderInfo &renderInfo, ChunkData &chunkData)
-{
-    int northIndex = x + (y * CHUNK_SIZE) + ((z - 1) * CHUNK_SIZE * CHUNK_HEIGHT);
-    int southIdx = x + (y * CHUNK_SIZE) + ((z + 1) * CHUNK_SIZE * CHUNK_HEIGHT);
-    int westIdx = (x - 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    int eastIdx = (x + 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    int bottomIdx = x + ((y - 1) * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    int topIdx = x + ((y + 1) * CHUNK_SIZE) + ((z)*CHUNK_SIZE * CHUNK_HEIGHT);
-
-    // Bottom face
-    if (y <= 0 || (chunkData.chunkData[bottomIdx] != block && chunkData.chunkData[bottomIdx] == BLOCK::AIR_BLOCK))
-    {
-        renderInfo.cover = renderInfo.cover | 16;
-    }
-
-    // Top face
-    if (y >= CHUNK_HEIGHT - 1 || chunkData.chunkData[topIdx] != block)
-    {
-        renderInfo.cover = renderInfo.cover | 32;
-    }
-    else
-    {
-        renderInfo.liquidOnTop = true;
-    }
-
-    // North face
-    if (z <= 0)
-    {
-        // check the north chunks data
-        BLOCK northBlock = (BLOCK)chunkData.northChunkData[x + (y * CHUNK_SIZE) + ((CHUNK_SIZE - 1) * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (northBlock == BLOCK::AIR_BLOCK)
+    const ChunkStorage &data = *chunkData.chunkData;
+    const ChunkSection &north = chunkData.northChunkData->getSection(section);
+    const ChunkSection &south = chunkData.southChunkData->getSection(section);
+    const ChunkSection &west = chunkData.westChunkData->getSection(section);
+    const ChunkSection &east = chunkData.eastChunkData->getSection(section);
+
+    // The section's rows with a layer from the sections below and above,
+    // [y + 1][z]. Past the bottom and top of the world they stay empty so
+    // the faces there show.
+    uint16_t opaque[SECTION_HEIGHT + 2][CHUNK_SIZE] = {};
+    uint16_t occupied[SECTION_HEIGHT + 2][CHUNK_SIZE] = {};
+    for (int i = 0; i < SECTION_HEIGHT + 2; i++)
+    {
+        int y = section * SECTION_HEIGHT + i - 1;
+        if (y < 0 || y >= CHUNK_HEIGHT)
+            continue;
+
+        const ChunkSection &rowSection = data.getSection(y / SECTION_HEIGHT);
+        for (int z = 0; z < CHUNK_SIZE; z++)
         {
-            renderInfo.cover = renderInfo.cover | 1;
+            opaque[i][z] = rowSection.opaqueRow(y % SECTION_HEIGHT, z);
+            occupied[i][z] = rowSection.occupiedRow(y % SECTION_HEIGHT, z);
         }
     }
-    else if (chunkData.chunkData[northIndex] == BLOCK::AIR_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 1;
-    }
 
-    // South face
-    if (z >= CHUNK_SIZE - 1)
-    {
-        BLOCK southBlock = (BLOCK)chunkData.southChunkData[x + (y * CHUNK_SIZE) + (0 * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (southBlock == BLOCK::AIR_BLOCK)
-        {
-            renderInfo.cover = renderInfo.cover | 2;
-        }
-    }
-    else if (chunkData.chunkData[southIdx] == BLOCK::AIR_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 2;
-    }
+    memset(faces.covers, 0, sizeof(faces.covers));
+    memset(faces.liquidOnTop, 0, sizeof(faces.liquidOnTop));
 
-    // West face
-    if (x <= 0)
+    for (int y = 0; y < SECTION_HEIGHT; y++)
     {
-        BLOCK westBlock = (BLOCK)chunkData.westChunkData[(CHUNK_SIZE - 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (westBlock == BLOCK::AIR_BLOCK)
-        {
-            renderInfo.cover = renderInfo.cover | 4;
-        }
-    }
-    else if (chunkData.chunkData[westIdx] == BLOCK::AIR_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 4;
-    }
+        const uint16_t *belowOpaque = opaque[y], *rowOpaque = opaque[y + 1], *aboveOpaque = opaque[y + 2];
+        const uint16_t *belowOccupied = occupied[y], *rowOccupied = occupied[y + 1], *aboveOccupied = occupied[y + 2];
 
-    // East face
-    if (x >= CHUNK_SIZE - 1)
-    {
-        BLOCK eastBlock = (BLOCK)chunkData.eastChunkData[0 + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (eastBlock == BLOCK::AIR_BLOCK)
+        for (int z = 0; z < CHUNK_SIZE; z++)
         {
-            renderInfo.cover = renderInfo.cover | 8;
+            uint16_t solid = rowOpaque[z];
+            uint16_t water = rowOccupied[z] & ~rowOpaque[z];
+            if ((solid | water) == 0)
+                continue;
+
+            uint16_t northOpaque = z > 0 ? rowOpaque[z - 1] : north.opaqueRow(y, CHUNK_SIZE - 1);
+            uint16_t northOccupied = z > 0 ? rowOccupied[z - 1] : north.occupiedRow(y, CHUNK_SIZE - 1);
+            uint16_t southOpaque = z < CHUNK_SIZE - 1 ? rowOpaque[z + 1] : south.opaqueRow(y, 0);
+            uint16_t southOccupied = z < CHUNK_SIZE - 1 ? rowOccupied[z + 1] : south.occupiedRow(y, 0);
+            uint16_t westOpaque = rowOpaque[z] << 1 | west.opaqueRow(y, z) >> (CHUNK_SIZE - 1);
+            uint16_t westOccupied = rowOccupied[z] << 1 | west.occupiedRow(y, z) >> (CHUNK_SIZE - 1);
+            uint16_t eastOpaque = rowOpaque[z] >> 1 | (east.opaqueRow(y, z) & 1) << (CHUNK_SIZE - 1);
+            uint16_t eastOccupied = rowOccupied[z] >> 1 | (east.occupiedRow(y, z) & 1) << (CHUNK_SIZE - 1);
+            uint16_t waterAbove = aboveOccupied[z] & ~aboveOpaque[z];
+
+            // In cover bit order
+            uint16_t visible[6] = {
+                (uint16_t)((solid & ~northOpaque) | (water & ~northOccupied)),
+                (uint16_t)((solid & ~southOpaque) | (water & ~southOccupied)),
+                (uint16_t)((solid & ~westOpaque) | (water & ~westOccupied)),
+                (uint16_t)((solid & ~eastOpaque) | (water & ~eastOccupied)),
+                (uint16_t)((solid & ~belowOpaque[z]) | (water & ~belowOccupied[z])),
+                (uint16_t)((solid & ~aboveOpaque[z]) | (water & ~waterAbove)),
+            };
+            for (int face = 0; face < 6; face++)
+            {
+                for (uint16_t bits = visible[face]; bits; bits &= bits - 1)
+                    faces.covers[__builtin_ctz(bits)][y][z] |= 1 << face;
+            }
+            for (uint16_t bits = water & waterAbove; bits; bits &= bits - 1)
+                faces.liquidOnTop[__builtin_ctz(bits)][y][z] = true;
         }
     }
-    else if (chunkData.chunkData[eastIdx] == BLOCK::AIR_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 8;
-    }
 }
 
-void updateOpaqueRenderInfo(int x, int y, int z, BlockRenderInfo &renderInfo, ChunkData &chunkData)
+bool World::collectChunkData(ChunkPos pos, ChunkData &chunkData)
 {
-    // North face
-    int northIndex = x + (y * CHUNK_SIZE) + ((z - 1) * CHUNK_SIZE * CHUNK_HEIGHT);
-    if (z <= 0)
-    {
-        // check the north chunks data
-        BLOCK northBlock = (BLOCK)chunkData.northChunkData[x + (y * CHUNK_SIZE) + ((CHUNK_SIZE - 1) * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (northBlock == BLOCK::AIR_BLOCK || northBlock == BLOCK::WATER_BLOCK)
-        {
-            renderInfo.cover = renderInfo.cover | 1;
-        }
-    }
-    else if (chunkData.chunkData[northIndex] == BLOCK::AIR_BLOCK || chunkData.chunkData[northIndex] == BLOCK::WATER_BLOCK)
+    std::unique_lock<std::mutex> data_lock(data_mtx);
+    if (!chunkDataExists({pos.x, pos.z}) || !chunkDataExists({pos.x, pos.z - 1}) || !chunkDataExists({pos.x, pos.z + 1}) || !chunkDataExists({pos.x - 1, pos.z}) || !chunkDataExists({pos.x + 1, pos.z}))
     {
-        renderInfo.cover = renderInfo.cover | 1;
+        return false;
     }
 
-    // South face
-    int southIdx = x + (y * CHUNK_SIZE) + ((z + 1) * CHUNK_SIZE * CHUNK_HEIGHT);
-    if (z >= CHUNK_SIZE - 1)
+    // only the snapshot pointers are copied, the mesh job itself runs
+    // without data_mtx. A cold chunk that fails to thaw is missing after all.
+    ChunkPos positions[5] = {{pos.x, pos.z}, {pos.x, pos.z - 1}, {pos.x, pos.z + 1}, {pos.x - 1, pos.z}, {pos.x + 1, pos.z}};
+    ChunkSnapshot snapshots[5];
+    for (int i = 0; i < 5; i++)
     {
-        BLOCK southBlock = (BLOCK)chunkData.southChunkData[x + (y * CHUNK_SIZE) + (0 * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (southBlock == BLOCK::AIR_BLOCK || southBlock == BLOCK::WATER_BLOCK)
-        {
-            renderInfo.cover = renderInfo.cover | 2;
-        }
-    }
-    else if (chunkData.chunkData[southIdx] == BLOCK::AIR_BLOCK || chunkData.chunkData[southIdx] == BLOCK::WATER_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 2;
+        ChunkSnapshot *data = findChunkData(positions[i]);
+        if (!data)
+            return false;
+        snapshots[i] = *data;
     }
 
-    // West face
-    int westIdx = (x - 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    if (x <= 0)
+    // Trees are still missing until the chunk is decorated
+    if (snapshots[0]->getStage() != DECORATED_STAGE)
+        return false;
+
+    chunkData = {snapshots[0], snapshots[1], snapshots[2], snapshots[3], snapshots[4]};
+    return true;
+}
+
+bool isOpaqueSection(const ChunkSection &section)
+{
+    if (!section.isUniform())
+        return false;
+    return blockProperties[section.get(0, 0, 0)].opaque;
+}
+
+// A section has no visible faces when it is all air, or when it is a single
+// opaque block boxed in by uniform opaque sections on all six sides. The
+// bottom and top of the world always show their faces.
+bool sectionIsHidden(ChunkData &chunkData, int section)
+{
+    const ChunkSection &chunkSection = chunkData.chunkData->getSection(section);
+    if (chunkSection.isUniform() && chunkSection.isEmpty())
+        return true;
+
+    if (section == 0 || section == SECTIONS_PER_CHUNK - 1)
+        return false;
+
+    return isOpaqueSection(chunkSection) &&
+           isOpaqueSection(chunkData.chunkData->getSection(section - 1)) &&
+           isOpaqueSection(chunkData.chunkData->getSection(section + 1)) &&
+           isOpaqueSection(chunkData.northChunkData->getSection(section)) &&
+           isOpaqueSection(chunkData.southChunkData->getSection(section)) &&
+           isOpaqueSection(chunkData.westChunkData->getSection(section)) &&
+           isOpaqueSection(chunkData.eastChunkData->getSection(section));
+}
+
+// Merges the visible faces of a section into rectangles, one face direction
+// and one slice of the section at a time. A rectangle grows along its first
+// axis while the faces match and then along the second while the whole row
+// matches. Faces only merge when they show the same block, rectangles never
+// cross the section.
+static_assert(SECTION_HEIGHT == CHUNK_SIZE, "meshSectionGreedy uses one square slice mask for every face axis");
+void meshSectionGreedy(int section, const SectionFaces &faces, const BLOCK blocks[CHUNK_SIZE][SECTION_HEIGHT][CHUNK_SIZE], ChunkMesh &chunkMesh)
+{
+    // Faces of the current slice, [first axis][second axis], AIR_BLOCK where
+    // there is none
+    BLOCK mask[CHUNK_SIZE][CHUNK_SIZE];
+    int baseY = section * SECTION_HEIGHT;
+
+    for (int face = 1; face <= 32; face <<= 1)
     {
-        BLOCK westBlock = (BLOCK)chunkData.westChunkData[(CHUNK_SIZE - 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (westBlock == BLOCK::AIR_BLOCK || westBlock == BLOCK::WATER_BLOCK)
+        for (int slice = 0; slice < CHUNK_SIZE; slice++)
         {
-            renderInfo.cover = renderInfo.cover | 4;
+            for (int a = 0; a < CHUNK_SIZE; a++)
+            {
+                for (int b = 0; b < CHUNK_SIZE; b++)
+                {
+                    // north and south slice along z, west and east along x,
+                    // bottom and top along y
+                    int x = face <= 2 ? a : face <= 8 ? slice : a;
+                    int y = face <= 8 ? b : slice;
+                    int z = face <= 2 ? slice : face <= 8 ? a : b;
+                    mask[a][b] = (faces.covers[x][y][z] & face) ? blocks[x][y][z] : BLOCK::AIR_BLOCK;
+                }
+            }
+
+            for (int b = 0; b < CHUNK_SIZE; b++)
+            {
+                for (int a = 0; a < CHUNK_SIZE; a++)
+                {
+                    BLOCK block = mask[a][b];
+                    if (block == BLOCK::AIR_BLOCK)
+                        continue;
+
+                    int w = 1;
+                    while (a + w < CHUNK_SIZE && mask[a + w][b] == block)
+                        w++;
+
+                    int h = 1;
+                    while (b + h < CHUNK_SIZE)
+                    {
+                        int i = 0;
+                        while (i < w && mask[a + i][b + h] == block)
+                            i++;
+                        if (i < w)
+                            break;
+                        h++;
+                    }
+
+                    for (int j = 0; j < h; j++)
+                    {
+                        for (int i = 0; i < w; i++)
+                            mask[a + i][b + j] = BLOCK::AIR_BLOCK;
+                    }
+
+                    int x = face <= 2 ? a : face <= 8 ? slice : a;
+                    int y = face <= 8 ? b : slice;
+                    int z = face <= 2 ? slice : face <= 8 ? a : b;
+                    emitFace(face, glm::ivec3(x, baseY + y, z), w, h, blockFaceTexture(block, face), false, chunkMesh.vertices_opaque);
+                }
+            }
         }
     }
-    else if (chunkData.chunkData[westIdx] == BLOCK::AIR_BLOCK || chunkData.chunkData[westIdx] == BLOCK::WATER_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 4;
-    }
+}
+
+void meshChunkData(ChunkPos pos, ChunkData &chunkData, ChunkMesh &chunkMesh)
+{
+    chunkMesh.pos = pos;
+    chunkMesh.isInitialized = false;
+    chunkMesh.transparentInitialized = false;
+
+    // Nothing above the highest column of the heightmap has faces
+    int maxHeight = chunkData.chunkData->getMaxHeight();
+    SectionFaces faces;
+    // The solid blocks of the section for the greedy mesher, air elsewhere
+    BLOCK blocks[CHUNK_SIZE][SECTION_HEIGHT][CHUNK_SIZE];
 
-    // East face
-    int eastIdx = (x + 1) + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    if (x >= CHUNK_SIZE - 1)
+    for (int section = 0; section * SECTION_HEIGHT <= maxHeight; section++)
     {
-        BLOCK eastBlock = (BLOCK)chunkData.eastChunkData[0 + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT)];
-        if (eastBlock == BLOCK::AIR_BLOCK || eastBlock == BLOCK::WATER_BLOCK)
+        if (sectionIsHidden(chunkData, section))
+            continue;
+
+        cullSectionFaces(chunkData, section, faces);
+        if (greedy_meshing)
+            memset(blocks, 0, sizeof(blocks));
+
+        int sectionTop = std::min((section + 1) * SECTION_HEIGHT - 1, maxHeight);
+        for (int x = 0; x < CHUNK_SIZE; x++) // X-axis
         {
-            renderInfo.cover = renderInfo.cover | 8;
+            for (int y = section * SECTION_HEIGHT; y <= sectionTop; y++) // Y-axis
+            {
+                int sectionY = y - section * SECTION_HEIGHT;
+                for (int z = 0; z < CHUNK_SIZE; z++) // Z-axis
+                {
+                    // Air and buried blocks have no faces to show
+                    char cover = faces.covers[x][sectionY][z];
+                    if (cover == 0)
+                        continue;
+
+                    BLOCK block = chunkData.chunkData->get(x, y, z);
+
+                    if (blockProperties[block].render == RENDER_LIQUID)
+                    {
+                        LiquidRenderInfo liquidRenderInfo = {
+                            block,
+                            cover,
+                            glm::ivec3(x, y, z),
+                            chunkMesh.vertices_transparent,
+                            faces.liquidOnTop[x][sectionY][z],
+                        };
+                        renderLiquidBlock(liquidRenderInfo);
+                    }
+                    else if (greedy_meshing)
+                    {
+                        blocks[x][sectionY][z] = block;
+                    }
+                    else
+                    {
+                        BlockRenderInfo renderOpaqueInfo = {
+                            block,
+                            cover,
+                            glm::ivec3(x, y, z),
+                            chunkMesh.vertices_opaque,
+                        };
+                        renderRegularBlock(renderOpaqueInfo);
+                    }
+                }
+            }
         }
-    }
-    else if (chunkData.chunkData[eastIdx] == BLOCK::AIR_BLOCK || chunkData.chunkData[eastIdx] == BLOCK::WATER_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 8;
-    }
 
-    // Bottom face
-    int bottomIdx = x + ((y - 1) * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
-    if (y <= 0 || chunkData.chunkData[bottomIdx] == BLOCK::AIR_BLOCK || chunkData.chunkData[bottomIdx] == BLOCK::WATER_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 16;
-    }
-    // Top face
-    int topIdx = x + ((y + 1) * CHUNK_SIZE) + ((z)*CHUNK_SIZE * CHUNK_HEIGHT);
-    if (y >= CHUNK_HEIGHT - 1 || chunkData.chunkData[topIdx] == BLOCK::AIR_BLOCK || chunkData.chunkData[topIdx] == BLOCK::WATER_BLOCK)
-    {
-        renderInfo.cover = renderInfo.cover | 32;
+        if (greedy_meshing)
+            meshSectionGreedy(section, faces, blocks, chunkMesh);
     }
 }
 
@@ -218,163 +328,165 @@ void World::generateNextMesh()
         return;
     }
 
-    std::unique_lock<std::mutex> data_lock(data_mtx);
-    if (!chunkDataExists({pos.x, pos.z}) || !chunkDataExists({pos.x, pos.z - 1}) || !chunkDataExists({pos.x, pos.z + 1}) || !chunkDataExists({pos.x - 1, pos.z}) || !chunkDataExists({pos.x + 1, pos.z}))
+    ChunkData chunkData;
+    if (!collectChunkData(pos, chunkData))
     {
         chunkGenerationTries++;
         return;
     }
 
-    ChunkData chunkData = {
-        chunkDataMap[{pos.x, pos.z}],
-        chunkDataMap[{pos.x, pos.z - 1}],
-        chunkDataMap[{pos.x, pos.z + 1}],
-        chunkDataMap[{pos.x - 1, pos.z}],
-        chunkDataMap[{pos.x + 1, pos.z}],
-    };
-    data_lock.unlock();
-
     chunksToMeshQueue.pop_front();
     queue_mtx.unlock();
 
     std::cout << "Generating chunk mesh: " << pos.x << ", " << pos.z << std::endl;
 
     ChunkMesh chunkMesh;
-    chunkMesh.pos = pos;
-    chunkMesh.isInitialized = false;
-    chunkMesh.transparentInitialized = false;
+    meshChunkData(pos, chunkData, chunkMesh);
 
-    unsigned int indiceOffset = 0;
-    unsigned int transparentIndiceOffset = 0;
+    size_t meshBytes = (chunkMesh.vertices_opaque.capacity() + chunkMesh.vertices_transparent.capacity()) * sizeof(Vertex);
 
-    assert(chunkData.chunkData.size() > 0 && chunkData.northChunkData.size() > 0 && chunkData.southChunkData.size() > 0 && chunkData.westChunkData.size() > 0 && chunkData.eastChunkData.size() > 0);
+    std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
+    ChunkMesh *oldMesh = chunkMeshMap.find(pos);
+    ChunkPos stalePos;
+    if (!oldMesh)
+        oldMesh = chunkMeshMap.findOccupant(pos, stalePos);
+    if (oldMesh)
+        releaseChunkMesh(*oldMesh);
+
+    chunkMeshMap.insert(pos, std::move(chunkMesh));
+    residency.setBytes(pos, MESH_TIER, meshBytes);
+    residency.touch(pos);
+    std::cout << "SUCCESSFUL: Generated chunk mesh: " << pos.x << ", " << pos.z << std::endl;
+}
 
-    for (int x = 0; x < CHUNK_SIZE; x++) // X-axis
-    {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) // Z-axis
-        {
-            for (int z = 0; z < CHUNK_SIZE; z++) // Y-axis
-            {
-                BLOCK block = (BLOCK)chunkData.chunkData[x + y * CHUNK_SIZE + (z * CHUNK_SIZE * CHUNK_HEIGHT)];
+size_t chunkMeshGpuBytes(const ChunkMesh &chunkMesh)
+{
+    size_t bytes = 0;
+    if (chunkMesh.isInitialized)
+        bytes += chunkMesh.vertices_opaque.size() * sizeof(Vertex);
+    if (chunkMesh.transparentInitialized)
+        bytes += chunkMesh.vertices_transparent.size() * sizeof(Vertex);
+    return bytes;
+}
 
-                if (block == BLOCK::WATER_BLOCK)
-                {
-                    LiquidRenderInfo liquidRenderInfo = {
-                        block,
-                        (char)0,
-                        glm::vec3((pos.x * CHUNK_SIZE) + x, y, (pos.z * CHUNK_SIZE) + z),
-                        chunkMesh.vertices_transparent,
-                        chunkMesh.indices_transparent,
-                        transparentIndiceOffset,
-                        false,
-                    };
-                    updateLiquidRenderInfo(block, x, y, z, liquidRenderInfo, chunkData);
-                    liquidRenderFunctions[block](liquidRenderInfo);
-                }
-                else
-                {
-                    BlockRenderInfo renderOpaqueInfo = {
-                        block,
-                        (char)0,
-                        glm::vec3((pos.x * CHUNK_SIZE) + x, y, (pos.z * CHUNK_SIZE) + z),
-                        chunkMesh.vertices_opaque,
-                        chunkMesh.indices_opaque,
-                        indiceOffset,
-                    };
-                    updateOpaqueRenderInfo(x, y, z, renderOpaqueInfo, chunkData);
-                    blockRenderFunctions[block](renderOpaqueInfo);
-                }
-            }
-        }
-    }
+// Grows the shared quad index buffer to cover a mesh of the given number of
+// faces, at least doubling it so a run of ever larger chunks doesn't upload
+// it every time. It keeps its name when it grows, so the vertex arrays it is
+// bound to stay valid. Uploaded through the copy target so no vertex array's
+// element buffer binding changes.
+void World::reserveQuadIndices(size_t quads)
+{
+    if (quads <= quadIndexCapacity)
+        return;
 
-    std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
-    chunkMeshMap[pos] = chunkMesh;
-    std::cout << "SUCCESSFUL: Generated chunk mesh: " << pos.x << ", " << pos.z << std::endl;
+    if (quadIndexBuffer == 0)
+        GLCall(glGenBuffers(1, &quadIndexBuffer));
+
+    quadIndexCapacity = std::max(quads, quadIndexCapacity * 2);
+    std::vector<unsigned int> indices;
+    fillQuadIndices(indices, quadIndexCapacity);
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, quadIndexBuffer));
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
 }
 
 void World::initializeTransparentChunk(ChunkMesh &chunkMesh)
 {
     GLCall(glGenVertexArrays(1, &chunkMesh.VAO_transparent));
     GLCall(glGenBuffers(1, &chunkMesh.VBO_transparent));
-    GLCall(glGenBuffers(1, &chunkMesh.EBO_transparent));
+    reserveQuadIndices(chunkMesh.vertices_transparent.size() / 4);
 
     bindChunkTransparent(chunkMesh);
 
-    GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0));
+    GLCall(glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, position)));
     GLCall(glEnableVertexAttribArray(0));
 
-    GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)sizeof(glm::vec3)));
+    GLCall(glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, texture)));
     GLCall(glEnableVertexAttribArray(1));
 
     GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * chunkMesh.vertices_transparent.size(), &chunkMesh.vertices_transparent.front(), GL_STATIC_DRAW));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * chunkMesh.indices_transparent.size(), &chunkMesh.indices_transparent.front(), GL_STATIC_DRAW));
 
     unbindChunk(chunkMesh);
 
     chunkMesh.transparentInitialized = true;
+    residency.setBytes(chunkMesh.pos, GPU_TIER, chunkMeshGpuBytes(chunkMesh));
 }
 
 void World::initializeOpaqueChunk(ChunkMesh &chunkMesh)
 {
     GLCall(glGenVertexArrays(1, &chunkMesh.VAO_opaque));
     GLCall(glGenBuffers(1, &chunkMesh.VBO_opaque));
-    GLCall(glGenBuffers(1, &chunkMesh.EBO_opaque));
+    reserveQuadIndices(chunkMesh.vertices_opaque.size() / 4);
 
     bindChunkOpaque(chunkMesh);
 
-    GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0));
+    GLCall(glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, position)));
     GLCall(glEnableVertexAttribArray(0));
 
-    GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)sizeof(glm::vec3)));
+    GLCall(glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, texture)));
     GLCall(glEnableVertexAttribArray(1));
 
     GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * chunkMesh.vertices_opaque.size(), &chunkMesh.vertices_opaque.front(), GL_STATIC_DRAW));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * chunkMesh.indices_opaque.size(), &chunkMesh.indices_opaque.front(), GL_STATIC_DRAW));
 
     unbindChunk(chunkMesh);
 
     chunkMesh.isInitialized = true;
+    residency.setBytes(chunkMesh.pos, GPU_TIER, chunkMeshGpuBytes(chunkMesh));
 }
 
-void World::renderChunkMeshes()
+// Chunk origins are passed relative to the camera, worked out in double so
+// nothing far from the world's origin loses precision on the way
+void setChunkOrigin(int originLoc, ChunkPos pos, glm::vec3 cameraPos)
+{
+    GLCall(glUniform3f(originLoc, (float)((double)pos.x * CHUNK_SIZE - cameraPos.x), (float)(0.0 - cameraPos.y), (float)((double)pos.z * CHUNK_SIZE - cameraPos.z)));
+}
+
+void World::renderChunkMeshes(int originLoc, glm::vec3 cameraPos)
 {
     std::lock_guard<std::mutex> lock(mesh_mtx);
 
-    // Render opaque chunks first (with depth writing and depth testing enabled)
-    for (auto &pair : chunkMeshMap)
+    // Meshes dropped on other threads hand their GL objects over to here
+    if (!buffersToDelete.empty())
+    {
+        GLCall(glDeleteBuffers(buffersToDelete.size(), buffersToDelete.data()));
+        buffersToDelete.clear();
+    }
+    if (!vertexArraysToDelete.empty())
     {
-        ChunkMesh &chunk = pair.second;
+        GLCall(glDeleteVertexArrays(vertexArraysToDelete.size(), vertexArraysToDelete.data()));
+        vertexArraysToDelete.clear();
+    }
 
-        if (chunk.indices_opaque.size() > 0)
+    // Render opaque chunks first (with depth writing and depth testing enabled)
+    chunkMeshMap.forEach([&](ChunkPos pos, ChunkMesh &chunk)
+                         {
+        if (chunk.vertices_opaque.size() > 0)
         {
             if (!chunk.isInitialized)
                 initializeOpaqueChunk(chunk);
 
+            setChunkOrigin(originLoc, pos, cameraPos);
             bindChunkOpaque(chunk);
-            GLCall(glDrawElements(GL_TRIANGLES, chunk.indices_opaque.size(), GL_UNSIGNED_INT, (void *)0));
+            GLCall(glDrawElements(GL_TRIANGLES, chunk.vertices_opaque.size() / 4 * 6, GL_UNSIGNED_INT, (void *)0));
             unbindChunk(chunk);
-        }
-    }
+        } });
 
     // Enable blending for transparency
     glDepthMask(GL_FALSE); // Disable depth writing for transparent blocks, but leave depth testing on
     glDisable(GL_CULL_FACE);
     //   Render transparent chunks next
-    for (auto &pair : chunkMeshMap)
-    {
-        ChunkMesh &chunk = pair.second;
-
-        if (chunk.indices_transparent.size() > 0)
+    chunkMeshMap.forEach([&](ChunkPos pos, ChunkMesh &chunk)
+                         {
+        if (chunk.vertices_transparent.size() > 0)
         {
             if (!chunk.transparentInitialized)
                 initializeTransparentChunk(chunk);
 
+            setChunkOrigin(originLoc, pos, cameraPos);
             bindChunkTransparent(chunk);
-            GLCall(glDrawElements(GL_TRIANGLES, chunk.indices_transparent.size(), GL_UNSIGNED_INT, (void *)0));
+            GLCall(glDrawElements(GL_TRIANGLES, chunk.vertices_transparent.size() / 4 * 6, GL_UNSIGNED_INT, (void *)0));
             unbindChunk(chunk);
-        }
-    }
+        } });
 
     // Re-enable depth writing and disable blending
     glEnable(GL_CULL_FACE);
@@ -384,35 +496,66 @@ void World::renderChunkMeshes()
 bool World::chunkMeshExists(ChunkPos pos)
 {
     std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
-    if (chunkMeshMap.find(pos) == chunkMeshMap.end())
-        return false;
-    return true;
+    return chunkMeshMap.contains(pos);
 }
 
 void World::removeChunkFromMap(ChunkPos pos)
 {
-    if (chunkMeshExists(pos))
+    std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
+    ChunkMesh *chunkMesh = chunkMeshMap.find(pos);
+    if (chunkMesh)
+        releaseChunkMesh(*chunkMesh);
+    chunkMeshMap.erase(pos);
+}
+
+// Queues the mesh's GL objects for deletion and drops it from the memory
+// accounting, the caller must hold mesh_mtx
+void World::releaseChunkMesh(ChunkMesh &chunkMesh)
+{
+    if (chunkMesh.isInitialized)
     {
-        chunkMeshMap.erase(pos);
+        buffersToDelete.push_back(chunkMesh.VBO_opaque);
+        vertexArraysToDelete.push_back(chunkMesh.VAO_opaque);
+        chunkMesh.isInitialized = false;
     }
+    if (chunkMesh.transparentInitialized)
+    {
+        buffersToDelete.push_back(chunkMesh.VBO_transparent);
+        vertexArraysToDelete.push_back(chunkMesh.VAO_transparent);
+        chunkMesh.transparentInitialized = false;
+    }
+    residency.setBytes(chunkMesh.pos, MESH_TIER, 0);
+    residency.setBytes(chunkMesh.pos, GPU_TIER, 0);
+}
+
+bool World::evictChunkMesh(ChunkPos pos)
+{
+    std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
+    ChunkMesh *chunkMesh = chunkMeshMap.find(pos);
+    if (!chunkMesh)
+        return false;
+
+    releaseChunkMesh(*chunkMesh);
+    chunkMeshMap.erase(pos);
+    return true;
 }
 
 void World::removeUnneededChunkMeshes(ChunkPos pos)
 {
+    std::unique_lock<std::mutex> mesh_lock(mesh_mtx);
     std::vector<ChunkPos> chunkPosToRemove;
-    for (const auto &pair : chunkMeshMap)
-    {
-        ChunkPos chunkPos = pair.first;
+    chunkMeshMap.forEach([&](ChunkPos chunkPos, ChunkMesh &)
+                         {
         glm::vec3 vector = glm::vec3(chunkPos.x - pos.x, 0, chunkPos.z - pos.z);
         if ((int)glm::length(vector) > (render_distance + 4))
         {
             chunkPosToRemove.push_back(chunkPos);
-        }
-    }
+        } });
 
     for (const auto &removePos : chunkPosToRemove)
     {
-        removeChunkFromMap(removePos);
+        releaseChunkMesh(*chunkMeshMap.find(removePos));
+        chunkMeshMap.erase(removePos);
     }
 }
 
@@ -489,5 +632,5 @@ ChunkMesh *World::getChunkFromMap(ChunkPos pos)
     {
         return nullptr;
     }
-    return &chunkMeshMap.at(pos);
+    return chunkMeshMap.find(pos);
 }
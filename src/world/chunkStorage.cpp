@@ -0,0 +1,611 @@
+#include <algorithm>
+#include <cstring>
+
+#include "world/chunkStorage.h"
+
+#if VOXEL_LAYOUT != VOXEL_LAYOUT_XYZ
+// Converts packed indices between the XYZ order of the serialized format and
+// the build's layout
+void repackLayout(const uint64_t *in, uint64_t *out, int bitsPerBlock, bool toLayout)
+{
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    size_t words = BLOCKS_PER_SECTION * bitsPerBlock / 64;
+    std::fill(out, out + words, 0);
+
+    unsigned int canonical = 0;
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+        for (int y = 0; y < SECTION_HEIGHT; y++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++, canonical++)
+            {
+                unsigned int from = (toLayout ? canonical : sectionIndex(x, y, z)) * bitsPerBlock;
+                unsigned int to = (toLayout ? sectionIndex(x, y, z) : canonical) * bitsPerBlock;
+                uint64_t value = (in[from >> 6] >> (from & 63)) & mask;
+                out[to >> 6] |= value << (to & 63);
+            }
+        }
+    }
+}
+#endif
+
+ChunkSection::ChunkSection() : bitsPerBlock(0), nonAirCount(0), palette{BLOCK::AIR_BLOCK}
+{
+}
+
+BLOCK ChunkSection::get(int x, int y, int z) const
+{
+    if (bitsPerBlock == 0)
+        return palette[0];
+
+    unsigned int bitIndex = sectionIndex(x, y, z) * bitsPerBlock;
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    return palette[(packed[bitIndex >> 6] >> (bitIndex & 63)) & mask];
+}
+
+void ChunkSection::set(int x, int y, int z, BLOCK block)
+{
+    BLOCK oldBlock = get(x, y, z);
+    if (oldBlock == block)
+        return;
+
+    // A uniform section only gets bitmaps once it stops being uniform
+    if (bitsPerBlock == 0)
+    {
+        occupied.assign(SECTION_WORDS, oldBlock != BLOCK::AIR_BLOCK ? ~0ull : 0);
+        opaque = {};
+        if (oldBlock == BLOCK::WATER_BLOCK)
+            opaque.assign(SECTION_WORDS, 0);
+    }
+
+    if (oldBlock == BLOCK::AIR_BLOCK)
+    {
+        nonAirCount++;
+    }
+    else if (block == BLOCK::AIR_BLOCK && --nonAirCount == 0)
+    {
+        fill(BLOCK::AIR_BLOCK);
+        return;
+    }
+
+    uint64_t paletteIdx = getPaletteIndex(block);
+
+    unsigned int bitIndex = sectionIndex(x, y, z) * bitsPerBlock;
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    uint64_t &word = packed[bitIndex >> 6];
+    word = (word & ~(mask << (bitIndex & 63))) | (paletteIdx << (bitIndex & 63));
+
+    unsigned int voxel = sectionIndex(x, y, z);
+    uint64_t bit = 1ull << (voxel & 63);
+    if (block == BLOCK::WATER_BLOCK && opaque.empty())
+        opaque = occupied;
+    if (block != BLOCK::AIR_BLOCK)
+        occupied[voxel >> 6] |= bit;
+    else
+        occupied[voxel >> 6] &= ~bit;
+    if (opaque.empty())
+        return;
+    if (isOpaqueBlock(block))
+        opaque[voxel >> 6] |= bit;
+    else
+        opaque[voxel >> 6] &= ~bit;
+}
+
+// The first block goes through set, which takes care of leaving the uniform
+// state and of growing the palette. The rest of the run only rewrites its
+// packed index and bitmap bits.
+void ChunkSection::fillColumn(int x, int z, int fromY, int toY, BLOCK block)
+{
+    set(x, fromY, z, block);
+    if (bitsPerBlock == 0)
+        return;
+    if (block == BLOCK::AIR_BLOCK)
+    {
+        for (int y = fromY + 1; y <= toY; y++)
+        {
+            set(x, y, z, block);
+        }
+        return;
+    }
+
+    uint64_t paletteIdx = getPaletteIndex(block);
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    bool opaqueBlock = isOpaqueBlock(block);
+    for (int y = fromY + 1; y <= toY; y++)
+    {
+        unsigned int voxel = sectionIndex(x, y, z);
+        unsigned int bitIndex = voxel * bitsPerBlock;
+        uint64_t &word = packed[bitIndex >> 6];
+        if (palette[(word >> (bitIndex & 63)) & mask] == BLOCK::AIR_BLOCK)
+            nonAirCount++;
+        word = (word & ~(mask << (bitIndex & 63))) | (paletteIdx << (bitIndex & 63));
+
+        uint64_t bit = 1ull << (voxel & 63);
+        occupied[voxel >> 6] |= bit;
+        if (opaque.empty())
+            continue;
+        if (opaqueBlock)
+            opaque[voxel >> 6] |= bit;
+        else
+            opaque[voxel >> 6] &= ~bit;
+    }
+}
+
+void ChunkSection::fill(BLOCK block)
+{
+    bitsPerBlock = 0;
+    nonAirCount = block == BLOCK::AIR_BLOCK ? 0 : BLOCKS_PER_SECTION;
+    palette = {block};
+    packed = {};
+    occupied = {};
+    opaque = {};
+}
+
+// Drops palette entries that are no longer referenced and collapses the
+// section back to a uniform fill when only one block is left.
+void ChunkSection::compact()
+{
+    if (bitsPerBlock == 0)
+        return;
+
+    // Stops looking as soon as every entry turned up, which is the usual case
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    std::vector<unsigned int> counts(palette.size(), 0);
+    size_t used = 0;
+    for (unsigned int i = 0; i < BLOCKS_PER_SECTION && used < palette.size(); i++)
+    {
+        unsigned int bitIndex = i * bitsPerBlock;
+        used += counts[(packed[bitIndex >> 6] >> (bitIndex & 63)) & mask]++ == 0;
+    }
+
+    std::vector<BLOCK> newPalette;
+    std::vector<uint64_t> remap(palette.size(), 0);
+    for (unsigned int i = 0; i < palette.size(); i++)
+    {
+        if (counts[i] > 0)
+        {
+            remap[i] = newPalette.size();
+            newPalette.push_back(palette[i]);
+        }
+    }
+
+    if (newPalette.size() == 1)
+    {
+        fill(newPalette[0]);
+        return;
+    }
+
+    int newBitsPerBlock = 1;
+    while ((1u << newBitsPerBlock) < newPalette.size())
+    {
+        newBitsPerBlock *= 2;
+    }
+    if (newPalette.size() == palette.size() && newBitsPerBlock == bitsPerBlock)
+        return;
+
+    std::vector<uint64_t> newPacked(BLOCKS_PER_SECTION * newBitsPerBlock / 64, 0);
+    for (unsigned int i = 0; i < BLOCKS_PER_SECTION; i++)
+    {
+        unsigned int oldBit = i * bitsPerBlock;
+        unsigned int newBit = i * newBitsPerBlock;
+        uint64_t value = remap[(packed[oldBit >> 6] >> (oldBit & 63)) & mask];
+        newPacked[newBit >> 6] |= value << (newBit & 63);
+    }
+
+    palette = std::move(newPalette);
+    packed = std::move(newPacked);
+    bitsPerBlock = newBitsPerBlock;
+}
+
+bool ChunkSection::isUniform() const
+{
+    return bitsPerBlock == 0;
+}
+
+bool ChunkSection::isEmpty() const
+{
+    return nonAirCount == 0;
+}
+
+int ChunkSection::getBitsPerBlock() const
+{
+    return bitsPerBlock;
+}
+
+size_t ChunkSection::getPaletteSize() const
+{
+    return palette.size();
+}
+
+size_t ChunkSection::memoryUsage() const
+{
+    return palette.capacity() * sizeof(BLOCK) + (packed.capacity() + occupied.capacity() + opaque.capacity()) * sizeof(uint64_t);
+}
+
+// Section layout: bits per block, palette size, non-air count (2 bytes),
+// one byte per palette entry, then the packed words as they sit in memory.
+void ChunkSection::serialize(std::vector<uint8_t> &out) const
+{
+    out.push_back(bitsPerBlock);
+    out.push_back(palette.size());
+    out.push_back(nonAirCount & 0xFF);
+    out.push_back(nonAirCount >> 8);
+    for (BLOCK block : palette)
+    {
+        out.push_back(block);
+    }
+
+    size_t offset = out.size();
+    out.resize(offset + packed.size() * sizeof(uint64_t));
+    if (packed.empty())
+        return;
+#if VOXEL_LAYOUT == VOXEL_LAYOUT_XYZ
+    memcpy(&out[offset], packed.data(), packed.size() * sizeof(uint64_t));
+#else
+    std::vector<uint64_t> canonical(packed.size());
+    repackLayout(packed.data(), canonical.data(), bitsPerBlock, false);
+    memcpy(&out[offset], canonical.data(), canonical.size() * sizeof(uint64_t));
+#endif
+}
+
+// Returns the number of bytes read, or 0 if the input is malformed
+size_t ChunkSection::deserialize(const uint8_t *in, size_t size)
+{
+    if (size < 4)
+        return 0;
+
+    int newBitsPerBlock = in[0];
+    size_t paletteSize = in[1];
+    size_t packedSize = BLOCKS_PER_SECTION * newBitsPerBlock / 64;
+    size_t total = 4 + paletteSize + packedSize * sizeof(uint64_t);
+    if (paletteSize == 0 || total > size || (newBitsPerBlock != 0 && newBitsPerBlock != 1 && newBitsPerBlock != 2 && newBitsPerBlock != 4 && newBitsPerBlock != 8))
+        return 0;
+    if (paletteSize > (1u << newBitsPerBlock))
+        return 0;
+
+    // Everything read from disk must be a known block, and every packed index
+    // must point into the palette
+    for (size_t i = 0; i < paletteSize; i++)
+    {
+        if (in[4 + i] >= BLOCK_COUNT)
+            return 0;
+    }
+    if (paletteSize < (1u << newBitsPerBlock))
+    {
+        uint64_t mask = (1ull << newBitsPerBlock) - 1;
+        for (size_t i = 0; i < packedSize; i++)
+        {
+            uint64_t word;
+            memcpy(&word, in + 4 + paletteSize + i * sizeof(uint64_t), sizeof(uint64_t));
+            for (int shift = 0; shift < 64; shift += newBitsPerBlock)
+            {
+                if (((word >> shift) & mask) >= paletteSize)
+                    return 0;
+            }
+        }
+    }
+
+    bitsPerBlock = newBitsPerBlock;
+    nonAirCount = in[2] | (in[3] << 8);
+    palette.resize(paletteSize);
+    for (size_t i = 0; i < paletteSize; i++)
+    {
+        palette[i] = (BLOCK)in[4 + i];
+    }
+    packed.resize(packedSize);
+    if (packedSize > 0)
+        memcpy(packed.data(), in + 4 + paletteSize, packedSize * sizeof(uint64_t));
+#if VOXEL_LAYOUT != VOXEL_LAYOUT_XYZ
+    if (packedSize > 0)
+    {
+        std::vector<uint64_t> canonical = packed;
+        repackLayout(canonical.data(), packed.data(), bitsPerBlock, true);
+    }
+#endif
+
+    rebuildBitmaps();
+    return total;
+}
+
+void ChunkSection::rebuildBitmaps()
+{
+    if (bitsPerBlock == 0)
+    {
+        occupied = {};
+        opaque = {};
+        return;
+    }
+
+    uint64_t occupiedFlags[256];
+    uint64_t opaqueFlags[256];
+    bool hasWater = false;
+    for (unsigned int i = 0; i < palette.size(); i++)
+    {
+        occupiedFlags[i] = palette[i] != BLOCK::AIR_BLOCK;
+        opaqueFlags[i] = isOpaqueBlock(palette[i]);
+        hasWater |= palette[i] == BLOCK::WATER_BLOCK;
+    }
+
+    occupied.assign(SECTION_WORDS, 0);
+    opaque.assign(SECTION_WORDS, 0);
+    uint64_t mask = (1ull << bitsPerBlock) - 1;
+    for (unsigned int i = 0; i < BLOCKS_PER_SECTION; i++)
+    {
+        unsigned int bitIndex = i * bitsPerBlock;
+        unsigned int paletteIdx = (packed[bitIndex >> 6] >> (bitIndex & 63)) & mask;
+        occupied[i >> 6] |= occupiedFlags[paletteIdx] << (i & 63);
+        opaque[i >> 6] |= opaqueFlags[paletteIdx] << (i & 63);
+    }
+    if (!hasWater)
+        opaque = {};
+}
+
+unsigned int ChunkSection::getPaletteIndex(BLOCK block)
+{
+    for (unsigned int i = 0; i < palette.size(); i++)
+    {
+        if (palette[i] == block)
+            return i;
+    }
+
+    palette.push_back(block);
+    if (palette.size() > (1u << bitsPerBlock))
+    {
+        grow(bitsPerBlock == 0 ? 1 : bitsPerBlock * 2);
+    }
+    return palette.size() - 1;
+}
+
+// Repack every voxel at a wider bit width. Widths are powers of two so an
+// entry never straddles two words. A uniform section unpacks to all zeros,
+// which is the index of its fill block.
+void ChunkSection::grow(int newBitsPerBlock)
+{
+    std::vector<uint64_t> newPacked(BLOCKS_PER_SECTION * newBitsPerBlock / 64, 0);
+
+    if (bitsPerBlock > 0)
+    {
+        uint64_t mask = (1ull << bitsPerBlock) - 1;
+        for (unsigned int i = 0; i < BLOCKS_PER_SECTION; i++)
+        {
+            unsigned int oldBit = i * bitsPerBlock;
+            unsigned int newBit = i * newBitsPerBlock;
+            uint64_t value = (packed[oldBit >> 6] >> (oldBit & 63)) & mask;
+            newPacked[newBit >> 6] |= value << (newBit & 63);
+        }
+    }
+
+    packed = std::move(newPacked);
+    bitsPerBlock = newBitsPerBlock;
+}
+
+ChunkStorage::ChunkStorage() : nonEmptyMask(0), stage(EMPTY_STAGE)
+{
+    std::fill(heights, heights + CHUNK_SIZE * CHUNK_SIZE, -1);
+    std::fill(biomes, biomes + CHUNK_SIZE * CHUNK_SIZE, PLAINS_BIOME);
+}
+
+BLOCK ChunkStorage::get(int x, int y, int z) const
+{
+    return sections[y / SECTION_HEIGHT].get(x, y % SECTION_HEIGHT, z);
+}
+
+void ChunkStorage::set(int x, int y, int z, BLOCK block)
+{
+    int section = y / SECTION_HEIGHT;
+    sections[section].set(x, y % SECTION_HEIGHT, z, block);
+
+    if (sections[section].isEmpty())
+    {
+        nonEmptyMask &= ~(1u << section);
+    }
+    else
+    {
+        nonEmptyMask |= 1u << section;
+    }
+
+    int16_t &height = heights[columnIndex(x, z)];
+    if (block != BLOCK::AIR_BLOCK && y > height)
+        height = y;
+    else if (block == BLOCK::AIR_BLOCK && y == height)
+        updateHeight(x, z, y - 1);
+}
+
+void ChunkStorage::fillColumn(int x, int z, int fromY, int toY, BLOCK block)
+{
+    if (fromY > toY)
+        return;
+
+    for (int section = fromY / SECTION_HEIGHT; section <= toY / SECTION_HEIGHT; section++)
+    {
+        int sectionBottom = section * SECTION_HEIGHT;
+        int runBottom = std::max(fromY, sectionBottom);
+        int runTop = std::min(toY, sectionBottom + SECTION_HEIGHT - 1);
+        sections[section].fillColumn(x, z, runBottom - sectionBottom, runTop - sectionBottom, block);
+
+        if (sections[section].isEmpty())
+        {
+            nonEmptyMask &= ~(1u << section);
+        }
+        else
+        {
+            nonEmptyMask |= 1u << section;
+        }
+    }
+
+    int16_t &height = heights[columnIndex(x, z)];
+    if (block != BLOCK::AIR_BLOCK && toY > height)
+        height = toY;
+    else if (block == BLOCK::AIR_BLOCK && height >= fromY && height <= toY)
+        updateHeight(x, z, fromY - 1);
+}
+
+void ChunkStorage::compact()
+{
+    for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+    {
+        sections[i].compact();
+    }
+}
+
+const ChunkSection &ChunkStorage::getSection(int section) const
+{
+    return sections[section];
+}
+
+ChunkSection &ChunkStorage::editSection(int section)
+{
+    return sections[section];
+}
+
+void ChunkStorage::rebuildColumns()
+{
+    nonEmptyMask = 0;
+    for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+    {
+        if (!sections[i].isEmpty())
+            nonEmptyMask |= 1u << i;
+    }
+
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            updateHeight(x, z, CHUNK_HEIGHT - 1);
+        }
+    }
+}
+
+void ChunkStorage::fillSection(int section, BLOCK block)
+{
+    sections[section].fill(block);
+
+    if (block == BLOCK::AIR_BLOCK)
+    {
+        nonEmptyMask &= ~(1u << section);
+    }
+    else
+    {
+        nonEmptyMask |= 1u << section;
+    }
+
+    int sectionBottom = section * SECTION_HEIGHT;
+    int sectionTop = sectionBottom + SECTION_HEIGHT - 1;
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            int16_t &height = heights[columnIndex(x, z)];
+            if (block != BLOCK::AIR_BLOCK && sectionTop > height)
+                height = sectionTop;
+            else if (block == BLOCK::AIR_BLOCK && height >= sectionBottom && height <= sectionTop)
+                updateHeight(x, z, sectionBottom - 1);
+        }
+    }
+}
+
+int ChunkStorage::getHeight(int x, int z) const
+{
+    return heights[columnIndex(x, z)];
+}
+
+int ChunkStorage::getMinHeight() const
+{
+    return *std::min_element(heights, heights + CHUNK_SIZE * CHUNK_SIZE);
+}
+
+int ChunkStorage::getMaxHeight() const
+{
+    return *std::max_element(heights, heights + CHUNK_SIZE * CHUNK_SIZE);
+}
+
+BIOME ChunkStorage::getBiome(int x, int z) const
+{
+    return (BIOME)biomes[columnIndex(x, z)];
+}
+
+void ChunkStorage::setBiome(int x, int z, BIOME biome)
+{
+    biomes[columnIndex(x, z)] = biome;
+}
+
+GenerationStage ChunkStorage::getStage() const
+{
+    return (GenerationStage)stage;
+}
+
+void ChunkStorage::setStage(GenerationStage newStage)
+{
+    stage = newStage;
+}
+
+// Finds the highest non-air block at or below fromY
+void ChunkStorage::updateHeight(int x, int z, int fromY)
+{
+    int y = fromY;
+    while (y >= 0 && !isOccupied(x, y, z))
+    {
+        // Skip empty sections in one step
+        if (!(nonEmptyMask & (1u << (y / SECTION_HEIGHT))))
+            y = (y / SECTION_HEIGHT) * SECTION_HEIGHT;
+        y--;
+    }
+    heights[columnIndex(x, z)] = y;
+}
+
+uint16_t ChunkStorage::getNonEmptyMask() const
+{
+    return nonEmptyMask;
+}
+
+size_t ChunkStorage::memoryUsage() const
+{
+    size_t bytes = sizeof(ChunkStorage);
+    for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+    {
+        bytes += sections[i].memoryUsage();
+    }
+    return bytes;
+}
+
+// The heights are rebuilt from the blocks when reading, only the biomes and
+// the generation stage follow the sections
+void ChunkStorage::serialize(std::vector<uint8_t> &out) const
+{
+    for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+    {
+        sections[i].serialize(out);
+    }
+    out.insert(out.end(), biomes, biomes + CHUNK_SIZE * CHUNK_SIZE);
+    out.push_back(stage);
+}
+
+bool ChunkStorage::deserialize(const uint8_t *in, size_t size)
+{
+    size_t offset = 0;
+    for (int i = 0; i < SECTIONS_PER_CHUNK; i++)
+    {
+        size_t read = sections[i].deserialize(in + offset, size - offset);
+        if (read == 0)
+            return false;
+        offset += read;
+    }
+
+    // Chunks written before the biome layer or the stage existed end early,
+    // and they were always fully generated
+    if (size - offset >= CHUNK_SIZE * CHUNK_SIZE)
+    {
+        memcpy(biomes, in + offset, CHUNK_SIZE * CHUNK_SIZE);
+        offset += CHUNK_SIZE * CHUNK_SIZE;
+    }
+    else
+    {
+        std::fill(biomes, biomes + CHUNK_SIZE * CHUNK_SIZE, PLAINS_BIOME);
+    }
+    if (offset < size && in[offset] > DECORATED_STAGE)
+        return false;
+    stage = offset < size ? (GenerationStage)in[offset] : DECORATED_STAGE;
+
+    rebuildColumns();
+    return true;
+}
@@ -0,0 +1,146 @@
+#include "world/editJournal.h"
+#include "world/chunkStorage.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// Same layout the chunk arrays used before they were split into sections
+inline unsigned int localBlockIndex(int x, int y, int z)
+{
+    return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_HEIGHT);
+}
+
+// A log record is chunk x, chunk z, local index and block, 13 bytes
+#define JOURNAL_RECORD_SIZE 13
+
+EditJournal::EditJournal(std::string path) : path(path), editCount(0)
+{
+}
+
+void EditJournal::load()
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    chunkEdits.clear();
+    editCount = 0;
+
+    std::ifstream file(path, std::ios::binary);
+    char record[JOURNAL_RECORD_SIZE];
+    while (file.read(record, JOURNAL_RECORD_SIZE))
+    {
+        ChunkPos pos;
+        uint32_t index;
+        memcpy(&pos.x, record, 4);
+        memcpy(&pos.z, record + 4, 4);
+        memcpy(&index, record + 8, 4);
+        uint8_t block = record[12];
+        if (index >= (BLOCKS_PER_CHUNK) || block >= BLOCK_COUNT)
+            continue;
+
+        auto inserted = chunkEdits[pos].insert_or_assign(index, (BLOCK)block);
+        editCount += inserted.second;
+    }
+    file.close();
+    if (editCount == 0)
+        return;
+
+    // Rewrite the log with only the last edit of every block. The compacted
+    // copy replaces the old log in a single rename, so a crash leaves one or
+    // the other.
+    log.close();
+    std::string compactedPath = path + ".tmp";
+    bool written;
+    {
+        std::ofstream compacted(compactedPath, std::ios::binary | std::ios::out | std::ios::trunc);
+        for (const auto &chunk : chunkEdits)
+        {
+            for (const auto &edit : chunk.second)
+            {
+                writeRecord(compacted, chunk.first, edit.first, edit.second);
+            }
+        }
+        compacted.close();
+        written = !compacted.fail();
+    }
+    std::error_code error;
+    if (written)
+        std::filesystem::rename(compactedPath, path, error);
+    if (!written || error)
+    {
+        std::cout << "Failed to compact edit journal: " << path << std::endl;
+        std::filesystem::remove(compactedPath, error);
+    }
+    std::cout << "Loaded " << editCount << " block edits in " << chunkEdits.size() << " chunks" << std::endl;
+}
+
+void EditJournal::record(ChunkPos pos, int x, int y, int z, BLOCK block)
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    unsigned int index = localBlockIndex(x, y, z);
+    auto inserted = chunkEdits[pos].insert_or_assign(index, block);
+    editCount += inserted.second;
+
+    if (!log.is_open())
+        openLog(std::ios::app);
+    writeRecord(log, pos, index, block);
+    log.flush();
+}
+
+bool EditJournal::hasEdits(ChunkPos pos)
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    return chunkEdits.count(pos) > 0;
+}
+
+bool EditJournal::hasEdit(ChunkPos pos, int x, int y, int z)
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    auto chunk = chunkEdits.find(pos);
+    return chunk != chunkEdits.end() && chunk->second.count(localBlockIndex(x, y, z)) > 0;
+}
+
+// Applies the chunk's edits on top of freshly generated or loaded data
+void EditJournal::replay(ChunkPos pos, ChunkStorage &data)
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    auto chunk = chunkEdits.find(pos);
+    if (chunk == chunkEdits.end())
+        return;
+
+    for (const auto &edit : chunk->second)
+    {
+        int x = edit.first % CHUNK_SIZE;
+        int y = (edit.first / CHUNK_SIZE) % CHUNK_HEIGHT;
+        int z = edit.first / (CHUNK_SIZE * CHUNK_HEIGHT);
+        data.set(x, y, z, edit.second);
+    }
+}
+
+size_t EditJournal::getEditCount()
+{
+    std::lock_guard<std::mutex> lock(journal_mtx);
+    return editCount;
+}
+
+void EditJournal::openLog(std::ios::openmode mode)
+{
+    std::filesystem::path logPath(path);
+    if (logPath.has_parent_path())
+        std::filesystem::create_directories(logPath.parent_path());
+
+    log.close();
+    log.open(path, std::ios::binary | std::ios::out | mode);
+    if (!log.is_open())
+        std::cout << "Failed to open edit journal: " << path << std::endl;
+}
+
+void EditJournal::writeRecord(std::ofstream &out, ChunkPos pos, unsigned int index, BLOCK block)
+{
+    char record[JOURNAL_RECORD_SIZE];
+    uint32_t index32 = index;
+    memcpy(record, &pos.x, 4);
+    memcpy(record + 4, &pos.z, 4);
+    memcpy(record + 8, &index32, 4);
+    record[12] = (char)block;
+    out.write(record, JOURNAL_RECORD_SIZE);
+}
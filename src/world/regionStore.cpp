@@ -0,0 +1,394 @@
+#include "world/regionStore.h"
+#include "world/chunkStorage.h"
+#include "world/chunkCodec.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+inline int regionCoord(int chunkCoord)
+{
+    return (chunkCoord - positiveMod(chunkCoord, REGION_SIZE)) / REGION_SIZE;
+}
+
+inline int regionEntryIndex(ChunkPos pos)
+{
+    return positiveMod(pos.x, REGION_SIZE) + positiveMod(pos.z, REGION_SIZE) * REGION_SIZE;
+}
+
+RegionStore::RegionStore(std::string directory) : directory(directory), writing(false), stop(false), chunksWritten(0), bytesWritten(0)
+{
+    writer = std::thread(&RegionStore::writerLoop, this);
+}
+
+RegionStore::~RegionStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        stop = true;
+    }
+    queueCondition.notify_all();
+    writer.join();
+
+    std::lock_guard<std::mutex> lock(file_mtx);
+    for (const std::string &path : writtenRegions)
+    {
+        compactRegion(path);
+    }
+    for (const auto &pair : readFiles)
+    {
+#ifndef _WIN32
+        close(pair.second);
+#endif
+    }
+}
+
+void RegionStore::save(ChunkPos pos, ChunkSnapshot data)
+{
+    if (!data)
+        return;
+
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    auto clean = cleanSnapshots.find(pos);
+    if (clean != cleanSnapshots.end())
+    {
+        bool unchanged = clean->second.lock() == data;
+        cleanSnapshots.erase(clean);
+        if (unchanged)
+            return;
+    }
+
+    pending[pos] = {std::move(data), nullptr};
+    failed.erase(pos);
+    queueCondition.notify_one();
+}
+
+// Queues a chunk in chunk codec form, it is written as is
+void RegionStore::saveEncoded(ChunkPos pos, std::vector<uint8_t> encoded)
+{
+    std::shared_ptr<const std::vector<uint8_t>> bytes = std::make_shared<const std::vector<uint8_t>>(std::move(encoded));
+
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    cleanSnapshots.erase(pos);
+    pending[pos] = {nullptr, std::move(bytes)};
+    failed.erase(pos);
+    queueCondition.notify_one();
+}
+
+ChunkSnapshot RegionStore::load(ChunkPos pos)
+{
+    std::shared_ptr<const std::vector<uint8_t>> encoded;
+    {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        auto queued = pending.find(pos);
+        if (queued != pending.end() && queued->second.data)
+        {
+            cleanSnapshots[pos] = queued->second.data;
+            return queued->second.data;
+        }
+        if (queued != pending.end())
+            encoded = queued->second.encoded;
+    }
+
+    std::shared_ptr<ChunkStorage> data = std::make_shared<ChunkStorage>();
+    bool valid = false;
+    if (encoded)
+    {
+        valid = decodeChunk(encoded->data(), encoded->size(), *data);
+    }
+    else
+    {
+        std::vector<uint8_t> bytes;
+        if (!readChunk(pos, bytes))
+            return nullptr;
+
+        if (!bytes.empty() && bytes[0] == 1)
+            valid = data->deserialize(bytes.data() + 1, bytes.size() - 1);
+        else if (!bytes.empty() && bytes[0] == 2)
+            valid = decodeChunk(bytes.data() + 1, bytes.size() - 1, *data);
+    }
+
+    if (!valid)
+    {
+        std::cout << "Corrupt chunk in region file at: " << pos.x << ", " << pos.z << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    cleanSnapshots[pos] = data;
+    return data;
+}
+
+// Blocks until every queued chunk has been written, or failed to and is
+// waiting for another try
+void RegionStore::flush()
+{
+    std::unique_lock<std::mutex> lock(queue_mtx);
+    idleCondition.wait(lock, [this]
+                       { return pending.size() == failed.size() && !writing; });
+}
+
+// True when data is exactly what the store already holds for pos
+bool RegionStore::isClean(ChunkPos pos, const ChunkSnapshot &data)
+{
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    auto clean = cleanSnapshots.find(pos);
+    return clean != cleanSnapshots.end() && clean->second.lock() == data;
+}
+
+void RegionStore::markClean(ChunkPos pos, const ChunkSnapshot &data)
+{
+    std::lock_guard<std::mutex> lock(queue_mtx);
+    cleanSnapshots[pos] = data;
+}
+
+size_t RegionStore::getChunksWritten() const
+{
+    return chunksWritten;
+}
+
+size_t RegionStore::getBytesWritten() const
+{
+    return bytesWritten;
+}
+
+void RegionStore::writerLoop()
+{
+    while (true)
+    {
+        std::unordered_map<ChunkPos, PendingChunk, ChunkPosHash, ChunkPosEqual> batch;
+        {
+            // Chunks that failed to write are tried again along with new
+            // ones, or on their own after a pause
+            std::unique_lock<std::mutex> lock(queue_mtx);
+            auto ready = [this]
+            { return stop || pending.size() > failed.size(); };
+            if (failed.empty())
+                queueCondition.wait(lock, ready);
+            else
+                queueCondition.wait_for(lock, std::chrono::seconds(REGION_RETRY_SECONDS), ready);
+            if (pending.empty())
+                return;
+
+            batch = pending;
+            failed.clear();
+            writing = true;
+        }
+
+        std::unordered_set<ChunkPos, ChunkPosHash, ChunkPosEqual> written;
+        for (const auto &pair : batch)
+        {
+            if (writeChunk(pair.first, pair.second))
+                written.insert(pair.first);
+        }
+
+        // Chunks stay in pending until they are on disk so load() never
+        // misses them. One that was saved again meanwhile stays queued, one
+        // that failed stays for another try.
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        for (const auto &pair : batch)
+        {
+            auto queued = pending.find(pair.first);
+            if (queued == pending.end() || queued->second.data != pair.second.data || queued->second.encoded != pair.second.encoded)
+                continue;
+            if (written.count(pair.first))
+                pending.erase(queued);
+            else
+                failed.insert(pair.first);
+        }
+        writing = false;
+        idleCondition.notify_all();
+
+        if (stop && !failed.empty())
+        {
+            std::cout << "Giving up on " << failed.size() << " chunks that failed to write" << std::endl;
+            return;
+        }
+    }
+}
+
+// Appends the chunk to its region file and repoints the table entry at it.
+// The old copy stays behind until the file is compacted, so a crash during
+// the write leaves the previous copy readable. Returns false when the chunk
+// didn't make it to the file.
+bool RegionStore::writeChunk(ChunkPos pos, const PendingChunk &chunk)
+{
+    std::vector<uint8_t> bytes(1, REGION_FORMAT_VERSION);
+    if (chunk.encoded)
+    {
+        bytes.resize(1 + chunk.encoded->size());
+        std::memcpy(bytes.data() + 1, chunk.encoded->data(), chunk.encoded->size());
+    }
+    else
+    {
+        encodeChunk(*chunk.data, bytes);
+    }
+
+    std::lock_guard<std::mutex> lock(file_mtx);
+    std::string path = regionPath(pos);
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::vector<RegionEntry> table(CHUNKS_PER_REGION, {0, 0});
+        std::ofstream create(path, std::ios::binary);
+        create.write((const char *)table.data(), table.size() * sizeof(RegionEntry));
+        create.close();
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    }
+    if (!file.is_open())
+    {
+        std::cout << "Failed to open region file: " << path << std::endl;
+        return false;
+    }
+
+    writtenRegions.insert(path);
+
+    file.seekp(0, std::ios::end);
+    RegionEntry entry = {(uint32_t)file.tellp(), (uint32_t)bytes.size()};
+    file.write((const char *)bytes.data(), bytes.size());
+    file.flush();
+    if (!file)
+    {
+        std::cout << "Failed to write chunk to region file: " << path << std::endl;
+        return false;
+    }
+
+    // The table entry is only written once the chunk itself is in the file
+    file.seekp(regionEntryIndex(pos) * sizeof(RegionEntry));
+    file.write((const char *)&entry, sizeof(RegionEntry));
+    file.flush();
+    if (!file)
+    {
+        std::cout << "Failed to write region table: " << path << std::endl;
+        return false;
+    }
+
+    chunksWritten++;
+    bytesWritten += bytes.size();
+    return true;
+}
+
+// Copies the serialized chunk out of its region file. Returns false if the
+// chunk was never stored.
+bool RegionStore::readChunk(ChunkPos pos, std::vector<uint8_t> &out)
+{
+    std::lock_guard<std::mutex> lock(file_mtx);
+    std::string path = regionPath(pos);
+
+#ifndef _WIN32
+    auto cached = readFiles.find(path);
+    if (cached == readFiles.end())
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        cached = readFiles.emplace(path, fd).first;
+    }
+    int fd = cached->second;
+
+    RegionEntry entry;
+    if (pread(fd, &entry, sizeof(RegionEntry), regionEntryIndex(pos) * sizeof(RegionEntry)) != sizeof(RegionEntry) || entry.size == 0)
+        return false;
+
+    out.resize(entry.size);
+    return pread(fd, out.data(), entry.size, entry.offset) == (ssize_t)entry.size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    RegionEntry entry = {0, 0};
+    file.seekg(regionEntryIndex(pos) * sizeof(RegionEntry));
+    file.read((char *)&entry, sizeof(RegionEntry));
+    if (!file || entry.size == 0)
+        return false;
+
+    out.resize(entry.size);
+    file.seekg(entry.offset);
+    file.read((char *)out.data(), entry.size);
+    return (bool)file;
+#endif
+}
+
+// The caller must hold file_mtx
+void RegionStore::closeReadFile(const std::string &path)
+{
+    auto cached = readFiles.find(path);
+    if (cached == readFiles.end())
+        return;
+#ifndef _WIN32
+    close(cached->second);
+#endif
+    readFiles.erase(cached);
+}
+
+// Rewrites a region file with only the chunks its table points to, in table
+// order. The new file replaces the old one in a single rename, so a crash
+// leaves one or the other. The caller must hold file_mtx.
+void RegionStore::compactRegion(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return;
+    size_t fileSize = file.tellg();
+    size_t tableBytes = CHUNKS_PER_REGION * sizeof(RegionEntry);
+    if (fileSize < tableBytes)
+        return;
+
+    std::vector<uint8_t> region(fileSize);
+    file.seekg(0);
+    file.read((char *)region.data(), fileSize);
+    if (!file)
+        return;
+    file.close();
+
+    std::vector<RegionEntry> table(CHUNKS_PER_REGION);
+    memcpy(table.data(), region.data(), tableBytes);
+    size_t liveBytes = 0;
+    for (RegionEntry &entry : table)
+    {
+        if ((size_t)entry.offset + entry.size > fileSize)
+            entry = {0, 0};
+        liveBytes += entry.size;
+    }
+    if (tableBytes + liveBytes == fileSize)
+        return;
+
+    std::vector<uint8_t> compacted(tableBytes);
+    for (RegionEntry &entry : table)
+    {
+        if (entry.size == 0)
+            continue;
+        size_t offset = compacted.size();
+        compacted.insert(compacted.end(), region.begin() + entry.offset, region.begin() + entry.offset + entry.size);
+        entry.offset = (uint32_t)offset;
+    }
+    memcpy(compacted.data(), table.data(), tableBytes);
+
+    std::string compactedPath = path + ".tmp";
+    {
+        std::ofstream out(compactedPath, std::ios::binary | std::ios::trunc);
+        out.write((const char *)compacted.data(), compacted.size());
+        if (!out)
+            return;
+    }
+    closeReadFile(path);
+    std::error_code error;
+    std::filesystem::rename(compactedPath, path, error);
+    if (error)
+        std::filesystem::remove(compactedPath, error);
+}
+
+std::string RegionStore::regionPath(ChunkPos pos) const
+{
+    return directory + "/r." + std::to_string(regionCoord(pos.x)) + "." + std::to_string(regionCoord(pos.z)) + ".region";
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "world/residency.h"
+
+ChunkResidency::ChunkResidency(int radius, size_t budget) : entries(radius), tierBytes{}, tierChunks{}, budget(budget), accessClock(0), evictions(0)
+{
+}
+
+void ChunkResidency::setBudget(size_t newBudget)
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    budget = newBudget;
+}
+
+size_t ChunkResidency::getBudget()
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    return budget;
+}
+
+bool ChunkResidency::isOverBudget()
+{
+    return bytesOverBudget() > 0;
+}
+
+size_t ChunkResidency::bytesOverBudget()
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    size_t total = 0;
+    for (int tier = 0; tier < TIER_COUNT; tier++)
+    {
+        total += tierBytes[tier];
+    }
+    return total > budget ? total - budget : 0;
+}
+
+void ChunkResidency::setBytes(ChunkPos pos, ResidencyTier tier, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    Entry *entry = entries.find(pos);
+    if (!entry)
+    {
+        if (bytes == 0)
+            return;
+
+        // The cell may still hold a chunk from the other side of the grid
+        ChunkPos stalePos;
+        Entry *stale = entries.findOccupant(pos, stalePos);
+        if (stale)
+            forget(*stale);
+
+        entry = &entries.insert(pos, Entry());
+        entry->lastAccess = ++accessClock;
+    }
+
+    tierChunks[tier] += (bytes > 0) - (entry->bytes[tier] > 0);
+    tierBytes[tier] += bytes;
+    tierBytes[tier] -= entry->bytes[tier];
+    entry->bytes[tier] = bytes;
+
+    for (int i = 0; i < TIER_COUNT; i++)
+    {
+        if (entry->bytes[i] > 0)
+            return;
+    }
+    entries.erase(pos);
+}
+
+void ChunkResidency::touch(ChunkPos pos)
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    Entry *entry = entries.find(pos);
+    if (entry)
+        entry->lastAccess = ++accessClock;
+}
+
+void ChunkResidency::countEviction()
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    evictions++;
+    recentEvictions.push_back(std::chrono::steady_clock::now());
+    dropOldEvictions();
+}
+
+std::vector<ChunkPos> ChunkResidency::getEvictionCandidates(ChunkPos center, int keepRadius)
+{
+    std::vector<std::pair<uint64_t, ChunkPos>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(residency_mtx);
+        entries.forEach([&](ChunkPos pos, Entry &entry)
+                        {
+            int dx = pos.x - center.x;
+            int dz = pos.z - center.z;
+            if (dx * dx + dz * dz > keepRadius * keepRadius)
+                candidates.push_back({entry.lastAccess, pos}); });
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b)
+              { return a.first < b.first; });
+
+    std::vector<ChunkPos> order;
+    order.reserve(candidates.size());
+    for (const auto &candidate : candidates)
+    {
+        order.push_back(candidate.second);
+    }
+    return order;
+}
+
+size_t ChunkResidency::getBytes(ChunkPos pos, ResidencyTier tier)
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+    Entry *entry = entries.find(pos);
+    return entry ? entry->bytes[tier] : 0;
+}
+
+ResidencyStats ChunkResidency::getStats()
+{
+    std::lock_guard<std::mutex> lock(residency_mtx);
+
+    dropOldEvictions();
+
+    ResidencyStats stats = {};
+    for (int tier = 0; tier < TIER_COUNT; tier++)
+    {
+        stats.chunks[tier] = tierChunks[tier];
+        stats.bytes[tier] = tierBytes[tier];
+        stats.totalBytes += tierBytes[tier];
+    }
+    stats.budget = budget;
+    stats.evictions = evictions;
+    stats.evictionsPerSecond = recentEvictions.size() / (float)EVICTION_RATE_WINDOW;
+    return stats;
+}
+
+// Only the evictions of the last few seconds count towards the rate
+void ChunkResidency::dropOldEvictions()
+{
+    auto now = std::chrono::steady_clock::now();
+    while (!recentEvictions.empty() && now - recentEvictions.front() > std::chrono::seconds(EVICTION_RATE_WINDOW))
+    {
+        recentEvictions.pop_front();
+    }
+}
+
+void ChunkResidency::forget(Entry &entry)
+{
+    for (int tier = 0; tier < TIER_COUNT; tier++)
+    {
+        tierChunks[tier] -= entry.bytes[tier] > 0;
+        tierBytes[tier] -= entry.bytes[tier];
+        entry.bytes[tier] = 0;
+    }
+}
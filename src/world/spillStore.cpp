@@ -0,0 +1,195 @@
+#include <algorithm>
+
+#include "world/spillStore.h"
+
+// Seconds on the steady clock, kept in an atomic for the TTL
+static int64_t spillClock()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SpillStore::Node SpillStore::retired = {};
+
+SpillStore::List::~List()
+{
+    Node *node = head.load();
+    if (node == &retired)
+        return;
+    size_t freed = freeNodes(node);
+    store->blockCount -= freed;
+    store->droppedCount += freed;
+}
+
+SpillStore::SpillStore(size_t maxBlocks) : maxBlocks(maxBlocks), blockCount(0), droppedCount(0)
+{
+}
+
+SpillStore::~SpillStore()
+{
+    for (Shard &shard : shards)
+    {
+        shard.lists.clear();
+    }
+}
+
+SpillStore::Shard &SpillStore::shardFor(ChunkPos pos)
+{
+    return shards[ChunkPosHash()(pos) % SPILL_SHARDS];
+}
+
+size_t SpillStore::freeNodes(Node *node)
+{
+    size_t count = 0;
+    while (node)
+    {
+        Node *next = node->next;
+        delete node;
+        node = next;
+        count++;
+    }
+    return count;
+}
+
+void SpillStore::append(ChunkPos pos, const BlockWithPos *blocks, size_t count)
+{
+    if (count == 0)
+        return;
+
+    // Link the blocks up first so the whole batch goes on with one swap
+    Node *first = nullptr;
+    Node *last = nullptr;
+    for (size_t i = 0; i < count; i++)
+    {
+        first = new Node{blocks[i], first};
+        if (!last)
+            last = first;
+    }
+    blockCount += count;
+
+    // A list retired between finding it and the swap is already out of the
+    // map, the next lookup creates a fresh one
+    while (true)
+    {
+        std::shared_ptr<List> list;
+        {
+            Shard &shard = shardFor(pos);
+            std::lock_guard<std::mutex> lock(shard.shard_mtx);
+            std::shared_ptr<List> &slot = shard.lists[pos];
+            if (!slot)
+                slot = std::make_shared<List>(this);
+            list = slot;
+        }
+
+        list->lastAppend = spillClock();
+        Node *head = list->head.load();
+        while (head != &retired)
+        {
+            last->next = head;
+            if (list->head.compare_exchange_weak(head, first))
+                return;
+        }
+    }
+}
+
+std::vector<BlockWithPos> SpillStore::take(ChunkPos pos)
+{
+    std::shared_ptr<List> list;
+    {
+        Shard &shard = shardFor(pos);
+        std::lock_guard<std::mutex> lock(shard.shard_mtx);
+        auto found = shard.lists.find(pos);
+        if (found == shard.lists.end())
+            return {};
+        list = std::move(found->second);
+        shard.lists.erase(found);
+    }
+
+    std::vector<BlockWithPos> blocks;
+    Node *node = list->head.exchange(&retired);
+    while (node)
+    {
+        blocks.push_back(node->block);
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+    blockCount -= blocks.size();
+
+    // The list is newest first
+    std::reverse(blocks.begin(), blocks.end());
+    return blocks;
+}
+
+bool SpillStore::hasPending(ChunkPos pos)
+{
+    Shard &shard = shardFor(pos);
+    std::lock_guard<std::mutex> lock(shard.shard_mtx);
+    auto found = shard.lists.find(pos);
+    return found != shard.lists.end() && found->second->head.load() != nullptr;
+}
+
+void SpillStore::cleanup(ChunkPos center, int keepRadius, std::chrono::seconds ttl)
+{
+    int64_t now = spillClock();
+    std::vector<std::pair<int, ChunkPos>> outside;
+    for (Shard &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.shard_mtx);
+        for (auto it = shard.lists.begin(); it != shard.lists.end();)
+        {
+            int dx = it->first.x - center.x;
+            int dz = it->first.z - center.z;
+            int distance = dx * dx + dz * dz;
+            if (distance <= keepRadius * keepRadius)
+            {
+                ++it;
+            }
+            else if (now - it->second->lastAppend.load() > ttl.count())
+            {
+                drop(*it->second);
+                it = shard.lists.erase(it);
+            }
+            else
+            {
+                outside.push_back({distance, it->first});
+                ++it;
+            }
+        }
+    }
+
+    // Over the bound the furthest lists go first, whatever their age
+    std::sort(outside.begin(), outside.end(), [](const auto &a, const auto &b)
+              { return a.first > b.first; });
+    for (size_t i = 0; i < outside.size() && blockCount.load() > maxBlocks; i++)
+    {
+        Shard &shard = shardFor(outside[i].second);
+        std::lock_guard<std::mutex> lock(shard.shard_mtx);
+        auto found = shard.lists.find(outside[i].second);
+        if (found == shard.lists.end())
+            continue;
+        drop(*found->second);
+        shard.lists.erase(found);
+    }
+}
+
+// Retires a list and frees what was pushed onto it so far
+void SpillStore::drop(List &list)
+{
+    size_t freed = freeNodes(list.head.exchange(&retired));
+    blockCount -= freed;
+    droppedCount += freed;
+}
+
+SpillStats SpillStore::getStats()
+{
+    SpillStats stats = {};
+    for (Shard &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.shard_mtx);
+        stats.chunks += shard.lists.size();
+    }
+    stats.blocks = blockCount.load();
+    stats.maxBlocks = maxBlocks;
+    stats.dropped = droppedCount.load();
+    return stats;
+}
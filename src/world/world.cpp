@@ -5,6 +5,7 @@
 
 #include "world/world.h"
 #include "world/chunkData.h"
+#include "world/chunkStorage.h"
 #include "world/chunkMesh.h"
 #include "world/chunkPos.h"
 #include "block.h"
@@ -15,9 +16,11 @@ void World::init()
 {
     focusMesh.init();
     worldCurrPos = {0, 0};
+    editJournal.load();
 }
 
-BLOCK World::getBlockData(glm::ivec3 blockPos)
+// Splits a world position into its chunk and the position inside it
+static void splitBlockPos(glm::ivec3 blockPos, ChunkPos &chunkPos, glm::ivec3 &local)
 {
     int chunk_x = blockPos.x / CHUNK_SIZE;
     int chunk_z = blockPos.z / CHUNK_SIZE;
@@ -43,27 +46,58 @@ BLOCK World::getBlockData(glm::ivec3 blockPos)
         chunk_z -= 1;
     }
 
-    ChunkPos chunkPos = {chunk_x,
-                         chunk_z};
+    chunkPos = {chunk_x, chunk_z};
+    local = {block_x, block_y, block_z};
+}
+
+BLOCK World::getBlockData(glm::ivec3 blockPos)
+{
+    ChunkPos chunkPos;
+    glm::ivec3 local;
+    splitBlockPos(blockPos, chunkPos, local);
 
     if (!chunkDataExists(chunkPos))
     {
         // TODO: this is bullshit, fix this later
         return BLOCK::AIR_BLOCK;
     }
-    std::vector<char> data = getChunkDataIfExists(chunkPos);
-    if (data.size() > 0)
+    ChunkSnapshot data = getChunkDataIfExists(chunkPos);
+    if (data && local.y < CHUNK_HEIGHT)
     {
-        BLOCK block = (BLOCK)data[block_x + (block_y * CHUNK_SIZE) + (block_z * CHUNK_SIZE * CHUNK_HEIGHT)];
-        // std::cout << "Found block: " << block << std::endl
-        //           << "at chunk: (" << chunkPos.x << ", " << chunkPos.z << ")" << std::endl
-        //           << "at pos: (" << block_x << ", " << block_y << ", " << block_z << ")" << std::endl;
-        return block;
+        return data->get(local.x, local.y, local.z);
     }
 
     return BLOCK::AIR_BLOCK;
 }
 
+// Cheaper than getBlockData when only solid or not matters, the occupancy
+// bitmap is read without decoding the palette
+bool World::isBlockOccupied(glm::ivec3 blockPos)
+{
+    ChunkPos chunkPos;
+    glm::ivec3 local;
+    splitBlockPos(blockPos, chunkPos, local);
+
+    if (!chunkDataExists(chunkPos))
+        return false;
+    ChunkSnapshot data = getChunkDataIfExists(chunkPos);
+    return data && local.y < CHUNK_HEIGHT && data->isOccupied(local.x, local.y, local.z);
+}
+
+// Height of the highest block in the column from the chunk's heightmap, -1
+// while the chunk isn't generated yet
+int World::getSurfaceHeight(int x, int z)
+{
+    ChunkPos chunkPos;
+    glm::ivec3 local;
+    splitBlockPos(glm::ivec3(x, 0, z), chunkPos, local);
+
+    if (!chunkDataExists(chunkPos))
+        return -1;
+    ChunkSnapshot data = getChunkDataIfExists(chunkPos);
+    return data ? data->getHeight(local.x, local.z) : -1;
+}
+
 void World::removeBlock(glm::ivec3 blockPos)
 {
     int chunk_x = blockPos.x / CHUNK_SIZE;
@@ -93,12 +127,11 @@ void World::removeBlock(glm::ivec3 blockPos)
     ChunkPos chunkPos = {chunk_x,
                          chunk_z};
 
-    std::vector<char> &data = getChunkDataIfExists(chunkPos);
-    if (data.size() > 0)
+    std::unique_lock<std::mutex> data_lock(data_mtx);
+    if (block_y < CHUNK_HEIGHT && editChunkData(chunkPos, block_x, block_y, block_z, BLOCK::AIR_BLOCK))
     {
-        data[block_x + (block_y * CHUNK_SIZE) + (block_z * CHUNK_SIZE * CHUNK_HEIGHT)] = BLOCK::AIR_BLOCK;
-        auto testData = chunkDataMap[chunkPos];
-        BLOCK testBlock = (BLOCK)testData[block_x + (block_y * CHUNK_SIZE) + (block_z * CHUNK_SIZE * CHUNK_HEIGHT)];
+        editJournal.record(chunkPos, block_x, block_y, block_z, BLOCK::AIR_BLOCK);
+        data_lock.unlock();
 
         std::unique_lock<std::mutex> queue_lock(mesh_queue_mtx);
         chunksToMeshQueue.push_front(chunkPos);
@@ -150,10 +183,11 @@ void World::createBlock(glm::ivec3 blockPos, BLOCK block) {
     ChunkPos chunkPos = {chunk_x,
                          chunk_z};
 
-    std::vector<char> &data = getChunkDataIfExists(chunkPos);
-    if (data.size() > 0)
+    std::unique_lock<std::mutex> data_lock(data_mtx);
+    if (block_y < CHUNK_HEIGHT && editChunkData(chunkPos, block_x, block_y, block_z, block))
     {
-        data[block_x + (block_y * CHUNK_SIZE) + (block_z * CHUNK_SIZE * CHUNK_HEIGHT)] = block;
+        editJournal.record(chunkPos, block_x, block_y, block_z, block);
+        data_lock.unlock();
 
         std::unique_lock<std::mutex> queue_lock(mesh_queue_mtx);
         chunksToMeshQueue.push_front(chunkPos);
@@ -277,31 +311,26 @@ void World::startWorldGeneration()
     }
 }
 
-void World::render()
+void World::render(unsigned int shaderId, glm::vec3 cameraPos)
 {
-    renderChunkMeshes();
+    int originLoc = glGetUniformLocation(shaderId, "chunkOrigin");
+    renderChunkMeshes(originLoc, cameraPos);
+
+    GLCall(glUniform3f(originLoc, focusPos.x - cameraPos.x, focusPos.y - cameraPos.y, focusPos.z - cameraPos.z));
     focusMesh.draw();
     focusMesh.reset();
 }
 
+// The focus mesh is a single block drawn at its own origin
 void World::updateFocusBlock(glm::ivec3 &pos, char &face)
 {
-    unsigned int indiceOffset = 0;
-
-    std::vector<UVcoords> textureCoords = blockTextureCoords[BLOCK::FOCUS];
-    UVcoords bottomTexCoords = textureCoords[0];
-    UVcoords sideTexCoords = textureCoords[1];
-    UVcoords topTexCoords = textureCoords[2];
-
-    glm::vec3 blockPos = glm::vec3(pos.x, pos.y, pos.z);
+    focusPos = pos;
 
     BlockRenderInfo renderInfo = {
         BLOCK::FOCUS,
         face,
-        blockPos,
-        focusMesh.vertices,
-        focusMesh.indices,
-        indiceOffset};
+        glm::ivec3(0, 0, 0),
+        focusMesh.vertices};
 
-    blockRenderFunctions[BLOCK::FOCUS](renderInfo);
+    renderRegularBlock(renderInfo);
 }
\ No newline at end of file